@@ -30,6 +30,21 @@ static size_t BufferPoolCount = 0;
 static size_t BufferPoolLen  = 0;
 static BUFFER **BufferPool = NULL;
 
+/* A released buffer keeps its allocation up to this size, so callers
+ * regularly needing a few KB don't reallocate on every use.  Larger
+ * buffers are shrunk back to LONG_STRING. */
+#define BUFFER_POOL_KEEP HUGE_STRING
+
+/* pool statistics, logged by mutt_buffer_pool_free() */
+static struct
+{
+  unsigned long gets;
+  unsigned long grows;      /* times the pool was enlarged */
+  unsigned long kept;       /* released buffers kept above LONG_STRING */
+  unsigned long shrunk;     /* released buffers shrunk to LONG_STRING */
+  size_t max_used;          /* most buffers out of the pool at once */
+} BufferPoolStats;
+
 
 /* Creates and initializes a BUFFER */
 BUFFER *mutt_buffer_new(void)
@@ -225,13 +240,17 @@ void mutt_buffer_substrcpy(BUFFER *buf, const char *beg, const char *end)
     mutt_buffer_strcpy_n(buf, beg, end - beg);
 }
 
+/* Called with an empty pool: doubles the number of pooled buffers. */
 static void increase_buffer_pool(void)
 {
   BUFFER *newbuf;
+  size_t add;
 
-  BufferPoolLen += 5;
+  add = BufferPoolLen ? BufferPoolLen : 5;
+  BufferPoolLen += add;
+  BufferPoolStats.grows++;
   safe_realloc(&BufferPool, BufferPoolLen * sizeof(BUFFER *));
-  while (BufferPoolCount < 5)
+  while (BufferPoolCount < add)
   {
     newbuf = mutt_buffer_new();
     mutt_buffer_increase_size(newbuf, LONG_STRING);
@@ -249,6 +268,11 @@ void mutt_buffer_pool_free(void)
 {
   muttdbg(1, "%zu of %zu returned to pool",
           BufferPoolCount, BufferPoolLen);
+  muttdbg(2, "buffer pool: %lu gets, %zu max in use, %lu grows, "
+          "%lu kept large, %lu shrunk",
+          BufferPoolStats.gets, BufferPoolStats.max_used,
+          BufferPoolStats.grows, BufferPoolStats.kept,
+          BufferPoolStats.shrunk);
 
   while (BufferPoolCount)
     mutt_buffer_free(&BufferPool[--BufferPoolCount]);
@@ -260,6 +284,9 @@ BUFFER *mutt_buffer_pool_get(void)
 {
   if (!BufferPoolCount)
     increase_buffer_pool();
+  BufferPoolStats.gets++;
+  if (BufferPoolLen - BufferPoolCount + 1 > BufferPoolStats.max_used)
+    BufferPoolStats.max_used = BufferPoolLen - BufferPoolCount + 1;
   return BufferPool[--BufferPoolCount];
 }
 
@@ -278,11 +305,15 @@ void mutt_buffer_pool_release(BUFFER **pbuf)
   }
 
   buf = *pbuf;
-  if ((buf->dsize > LONG_STRING*2) || (buf->dsize < LONG_STRING))
+  if ((buf->dsize > BUFFER_POOL_KEEP) || (buf->dsize < LONG_STRING))
   {
+    if (buf->dsize > BUFFER_POOL_KEEP)
+      BufferPoolStats.shrunk++;
     buf->dsize = LONG_STRING;
     safe_realloc(&buf->data, buf->dsize);
   }
+  else if (buf->dsize > LONG_STRING)
+    BufferPoolStats.kept++;
   mutt_buffer_clear(buf);
   BufferPool[BufferPoolCount++] = buf;
 
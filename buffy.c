@@ -44,6 +44,7 @@
 #include <string.h>
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <dirent.h>
 #include <utime.h>
 #include <ctype.h>
@@ -56,6 +57,17 @@ static time_t BuffyStatsTime = 0; /* last time we check performed mail_check_sta
 time_t BuffyDoneTime = 0;       /* last time we knew for sure how much mail there was. */
 static short BuffyCount = 0;    /* how many boxes with new mail */
 static short BuffyNotify = 0;   /* # of unnotified new boxes */
+static unsigned short BuffyRound = 0; /* number of the current check */
+
+/* A mailbox whose poll takes at least BUFFY_SLOW_MS milliseconds has its
+ * polling interval doubled, up to BUFFY_MAX_BACKOFF times.  Only polls
+ * without $mail_check_stats work are timed for this: counting the
+ * messages of a large folder is slow even on a fast file system.  Once a check
+ * has spent BUFFY_CHECK_MS polling, the remaining mailboxes are left
+ * for the next check, so slow (e.g. NFS) folders don't stall the UI. */
+#define BUFFY_SLOW_MS     250
+#define BUFFY_MAX_BACKOFF 4
+#define BUFFY_CHECK_MS    500
 
 static BUFFY *buffy_get(const char *path);
 
@@ -487,12 +499,17 @@ static int buffy_maildir_check_dir(BUFFY *mailbox, const char *dir_name, int che
   struct dirent *de;
   char *p;
   int rc = 0;
+  int count, unread, flagged;
   struct stat sb;
 
   path = mutt_buffer_pool_get();
   msgpath = mutt_buffer_pool_get();
   mutt_buffer_printf(path, "%s/%s", mutt_b2s(mailbox->pathbuf), dir_name);
 
+  count = mailbox->msg_count;
+  unread = mailbox->msg_unread;
+  flagged = mailbox->msg_flagged;
+
   /* when $mail_check_recent is set, if the new/ directory hasn't been modified since
    * the user last exited the mailbox, then we know there is no recent mail.
    */
@@ -556,6 +573,15 @@ static int buffy_maildir_check_dir(BUFFY *mailbox, const char *dir_name, int che
 
   closedir(dirp);
 
+#ifdef USE_INOTIFY
+  /* from now on the monitor keeps the counts up to date */
+  if (check_stats)
+    mutt_monitor_maildir_seed(mailbox, dir_name,
+                              mailbox->msg_count - count,
+                              mailbox->msg_unread - unread,
+                              mailbox->msg_flagged - flagged);
+#endif
+
 cleanup:
   mutt_buffer_pool_release(&path);
   mutt_buffer_pool_release(&msgpath);
@@ -571,6 +597,12 @@ static int buffy_maildir_check(BUFFY *mailbox, int check_stats)
 {
   int rc, check_new = 1;
 
+#ifdef USE_INOTIFY
+  /* counts kept by the monitor need no scan, so use them on every check */
+  if (mutt_monitor_maildir_stats(mailbox) == 0)
+    check_stats = 0;
+  else
+#endif
   if (check_stats)
   {
     mailbox->msg_count   = 0;
@@ -628,6 +660,13 @@ static int buffy_mbox_check(BUFFY *mailbox, struct stat *sb, int check_stats)
   if (check_stats &&
       (mutt_stat_timespec_compare(sb, MUTT_STAT_MTIME, &mailbox->stats_last_checked) > 0))
   {
+    /* if mail was only appended, just count the new messages */
+    if (mailbox->stats_size > 0 && sb->st_size > mailbox->stats_size &&
+        mbox_parse_appended(mutt_b2s(mailbox->pathbuf), &mailbox->stats_size,
+                            &mailbox->stats_last_checked, &mailbox->msg_count,
+                            &mailbox->msg_unread, &mailbox->msg_flagged) == 0)
+      return rc;
+
     if (mx_open_mailbox(mutt_b2s(mailbox->pathbuf),
                         MUTT_READONLY | MUTT_QUIET | MUTT_NOSORT | MUTT_PEEK,
                         &ctx) != NULL)
@@ -636,6 +675,7 @@ static int buffy_mbox_check(BUFFY *mailbox, struct stat *sb, int check_stats)
       mailbox->msg_unread      = ctx.unread;
       mailbox->msg_flagged     = ctx.flagged;
       mailbox->stats_last_checked = ctx.mtime;
+      mailbox->stats_size         = ctx.size;
       mx_close_mailbox(&ctx, 0);
     }
   }
@@ -643,24 +683,179 @@ static int buffy_mbox_check(BUFFY *mailbox, struct stat *sb, int check_stats)
   return rc;
 }
 
+static unsigned long long buffy_millis(void)
+{
+  struct timeval tv;
+
+  if (gettimeofday(&tv, NULL) < 0)
+    return 0;
+  return ((unsigned long long) tv.tv_sec * 1000ULL) +
+    (unsigned long long) (tv.tv_usec / 1000);
+}
+
+static void buffy_update_notify(BUFFY *tmp)
+{
+  if (!tmp->new)
+    tmp->notified = 0;
+  else
+  {
+    /* pretend we've already notified for the mailbox */
+    if (tmp->nonotify)
+      tmp->notified = 1;
+    else if (!tmp->notified)
+      BuffyNotify++;
+  }
+}
+
+/* Checks a single mailbox for new mail and updates BuffyCount */
+static void buffy_check(BUFFY *tmp, struct stat *contex_sb, int check_stats)
+{
+  struct stat sb;
+#ifdef USE_SIDEBAR
+  short orig_new;
+  int orig_count, orig_unread, orig_flagged;
+#endif
+
+  sb.st_size = 0;
+
+#ifdef USE_SIDEBAR
+  orig_new = tmp->new;
+  orig_count = tmp->msg_count;
+  orig_unread = tmp->msg_unread;
+  orig_flagged = tmp->msg_flagged;
+#endif
+
+  if (tmp->magic != MUTT_IMAP)
+  {
+    tmp->new = 0;
+#ifdef USE_POP
+    if (mx_is_pop(mutt_b2s(tmp->pathbuf)))
+      tmp->magic = MUTT_POP;
+    else
+#endif
+      if (stat(mutt_b2s(tmp->pathbuf), &sb) != 0 ||
+          (S_ISREG(sb.st_mode) && sb.st_size == 0) ||
+          (!tmp->magic &&
+           (tmp->magic = mx_get_magic(mutt_b2s(tmp->pathbuf))) <= 0))
+      {
+        /* if the mailbox still doesn't exist, set the newly created flag to
+         * be ready for when it does. */
+        tmp->newly_created = 1;
+        tmp->magic = 0;
+        tmp->size = 0;
+        return;
+      }
+  }
+
+  /* check to see if the folder is the currently selected folder
+   * before polling */
+  if (!Context || !Context->path ||
+      ((tmp->magic == MUTT_IMAP || tmp->magic == MUTT_POP ) ?
+       mutt_strcmp(mutt_b2s(tmp->pathbuf), Context->path) :
+       (sb.st_dev != contex_sb->st_dev || sb.st_ino != contex_sb->st_ino)))
+  {
+    switch (tmp->magic)
+    {
+      case MUTT_MBOX:
+      case MUTT_MMDF:
+        if (buffy_mbox_check(tmp, &sb, check_stats) > 0)
+          BuffyCount++;
+        break;
+
+      case MUTT_MAILDIR:
+        if (buffy_maildir_check(tmp, check_stats) > 0)
+          BuffyCount++;
+        break;
+
+      case MUTT_MH:
+        if (mh_buffy(tmp, check_stats) > 0)
+          BuffyCount++;
+        break;
+    }
+  }
+  else if (option(OPTCHECKMBOXSIZE) && Context && Context->path)
+    tmp->size = (off_t) sb.st_size;   /* update the size of current folder */
+
+#ifdef USE_SIDEBAR
+  if ((orig_new != tmp->new) ||
+      (orig_count != tmp->msg_count) ||
+      (orig_unread != tmp->msg_unread) ||
+      (orig_flagged != tmp->msg_flagged))
+    mutt_set_current_menu_redraw(REDRAW_SIDEBAR);
+#endif
+
+  buffy_update_notify(tmp);
+}
+
+/* Polls a mailbox, unless it is a slow mailbox whose next poll isn't due
+ * yet or the check has run out of time.  In that case the state from
+ * its last poll is counted instead.
+ */
+static void buffy_poll(BUFFY *tmp, struct stat *contex_sb, int check_stats,
+                       int force, time_t t, unsigned long long deadline)
+{
+  unsigned long long start, elapsed;
+
+  if (tmp->poll_round == BuffyRound)
+    return;
+  tmp->poll_round = BuffyRound;
+
+  if (tmp->nopoll)
+    return;
+
+  if (!force && tmp->magic != MUTT_IMAP)
+  {
+    if (t < tmp->poll_next || buffy_millis() >= deadline)
+    {
+      if (t >= tmp->poll_next)
+        tmp->poll_deferred = 1;
+      if (tmp->new)
+        BuffyCount++;
+      buffy_update_notify(tmp);
+      return;
+    }
+  }
+
+  start = buffy_millis();
+  buffy_check(tmp, contex_sb, check_stats);
+  elapsed = buffy_millis() - start;
+  tmp->poll_deferred = 0;
+
+  if (elapsed >= BUFFY_SLOW_MS)
+  {
+    /* leave the schedule alone, see BUFFY_SLOW_MS */
+    if (check_stats)
+      return;
+
+    if (tmp->poll_backoff < BUFFY_MAX_BACKOFF)
+      tmp->poll_backoff++;
+    tmp->poll_next = t + (BuffyTimeout << tmp->poll_backoff);
+    muttdbg(2, "%s took %llums, next poll in %ds", mutt_b2s(tmp->pathbuf),
+            elapsed, BuffyTimeout << tmp->poll_backoff);
+  }
+  else
+  {
+    tmp->poll_backoff = 0;
+    tmp->poll_next = 0;
+  }
+}
+
 /* Check all Incoming for new mail and total/new/flagged messages
  * The force argument may be any combination of the following values:
  *   MUTT_BUFFY_CHECK_FORCE        ignore BuffyTimeout and check for new mail
  *   MUTT_BUFFY_CHECK_FORCE_STATS  ignore BuffyTimeout and calculate statistics
+ *
+ * Unless forced, slow mailboxes are polled less often and polling stops
+ * after BUFFY_CHECK_MS, see buffy_poll().
  */
 int mutt_buffy_check(int force)
 {
   BUFFY *tmp;
-  struct stat sb;
   struct stat contex_sb;
   time_t t;
   int check_stats = 0;
-#ifdef USE_SIDEBAR
-  short orig_new;
-  int orig_count, orig_unread, orig_flagged;
-#endif
+  unsigned long long deadline;
 
-  sb.st_size=0;
   contex_sb.st_dev=0;
   contex_sb.st_ino=0;
 
@@ -688,6 +883,7 @@ int mutt_buffy_check(int force)
   BuffyTime = t;
   BuffyCount = 0;
   BuffyNotify = 0;
+  BuffyRound++;
 
 #ifdef USE_IMAP
   BuffyCount += imap_buffy_check(force, check_stats);
@@ -701,88 +897,15 @@ int mutt_buffy_check(int force)
     contex_sb.st_ino=0;
   }
 
-  for (tmp = Incoming; tmp; tmp = tmp->next)
-  {
-    if (tmp->nopoll)
-      continue;
+  deadline = buffy_millis() + BUFFY_CHECK_MS;
 
-#ifdef USE_SIDEBAR
-    orig_new = tmp->new;
-    orig_count = tmp->msg_count;
-    orig_unread = tmp->msg_unread;
-    orig_flagged = tmp->msg_flagged;
-#endif
-
-    if (tmp->magic != MUTT_IMAP)
-    {
-      tmp->new = 0;
-#ifdef USE_POP
-      if (mx_is_pop(mutt_b2s(tmp->pathbuf)))
-        tmp->magic = MUTT_POP;
-      else
-#endif
-        if (stat(mutt_b2s(tmp->pathbuf), &sb) != 0 ||
-            (S_ISREG(sb.st_mode) && sb.st_size == 0) ||
-            (!tmp->magic &&
-             (tmp->magic = mx_get_magic(mutt_b2s(tmp->pathbuf))) <= 0))
-        {
-          /* if the mailbox still doesn't exist, set the newly created flag to
-           * be ready for when it does. */
-          tmp->newly_created = 1;
-          tmp->magic = 0;
-          tmp->size = 0;
-          continue;
-        }
-    }
-
-    /* check to see if the folder is the currently selected folder
-     * before polling */
-    if (!Context || !Context->path ||
-        ((tmp->magic == MUTT_IMAP || tmp->magic == MUTT_POP ) ?
-         mutt_strcmp(mutt_b2s(tmp->pathbuf), Context->path) :
-         (sb.st_dev != contex_sb.st_dev || sb.st_ino != contex_sb.st_ino)))
-    {
-      switch (tmp->magic)
-      {
-        case MUTT_MBOX:
-        case MUTT_MMDF:
-          if (buffy_mbox_check(tmp, &sb, check_stats) > 0)
-            BuffyCount++;
-          break;
-
-        case MUTT_MAILDIR:
-          if (buffy_maildir_check(tmp, check_stats) > 0)
-            BuffyCount++;
-          break;
-
-        case MUTT_MH:
-          if (mh_buffy(tmp, check_stats) > 0)
-            BuffyCount++;
-          break;
-      }
-    }
-    else if (option(OPTCHECKMBOXSIZE) && Context && Context->path)
-      tmp->size = (off_t) sb.st_size;   /* update the size of current folder */
-
-#ifdef USE_SIDEBAR
-    if ((orig_new != tmp->new) ||
-        (orig_count != tmp->msg_count) ||
-        (orig_unread != tmp->msg_unread) ||
-        (orig_flagged != tmp->msg_flagged))
-      mutt_set_current_menu_redraw(REDRAW_SIDEBAR);
-#endif
+  /* mailboxes left over by the last check go first */
+  for (tmp = Incoming; tmp; tmp = tmp->next)
+    if (tmp->poll_deferred)
+      buffy_poll(tmp, &contex_sb, check_stats, force, t, deadline);
 
-    if (!tmp->new)
-      tmp->notified = 0;
-    else
-    {
-      /* pretend we've already notified for the mailbox */
-      if (tmp->nonotify)
-        tmp->notified = 1;
-      else if (!tmp->notified)
-        BuffyNotify++;
-    }
-  }
+  for (tmp = Incoming; tmp; tmp = tmp->next)
+    buffy_poll(tmp, &contex_sb, check_stats, force, t, deadline);
 
   BuffyDoneTime = BuffyTime;
   return (BuffyCount);
@@ -42,6 +42,13 @@ typedef struct buffy_t
   short newly_created;          /* mbox or mmdf just popped into existence */
   struct timespec last_visited;         /* time of last exit from this mailbox */
   struct timespec stats_last_checked;   /* mtime of mailbox the last time stats where checked. */
+  LOFF_T stats_size;                    /* size of mbox the last time stats where checked. */
+
+  /* polling state, see mutt_buffy_check() */
+  time_t poll_next;             /* slow mailbox: don't poll before this time */
+  short poll_backoff;           /* polling interval is $mail_check << poll_backoff */
+  short poll_deferred;          /* skipped by the last check, poll it first */
+  unsigned short poll_round;    /* last check that handled this mailbox */
 } BUFFY;
 
 WHERE BUFFY *Incoming;
@@ -364,7 +364,7 @@ int iconv_close(iconv_t cd)
  * MUTT_ICONV_HOOK_FROM acts on charset-hooks, not at all on iconv-hooks.
  */
 
-iconv_t mutt_iconv_open(const char *tocode, const char *fromcode, int flags)
+static iconv_t charset_iconv_open(const char *tocode, const char *fromcode, int flags)
 {
   char tocode1[SHORT_STRING];
   char fromcode1[SHORT_STRING];
@@ -396,6 +396,132 @@ iconv_t mutt_iconv_open(const char *tocode, const char *fromcode, int flags)
   return (iconv_t) -1;
 }
 
+/*
+ * Resolving charset names and iconv_open() are expensive compared to
+ * converting a single header field, so a few descriptors are kept
+ * around.  mutt_iconv_open() hands out an idle cached descriptor for
+ * the same arguments, reset to its initial state, and
+ * mutt_iconv_close() puts it back.  Conversions iconv doesn't support
+ * are remembered too.
+ */
+
+#define ICONV_CACHE_SIZE 8
+
+struct iconv_cache
+{
+  char *tocode;
+  char *fromcode;
+  int flags;
+  iconv_t cd;
+  unsigned int busy : 1;
+  unsigned int stale : 1;       /* close instead of caching on release */
+  unsigned long used;
+};
+
+static struct iconv_cache IconvCache[ICONV_CACHE_SIZE];
+static unsigned long IconvCacheClock = 0;
+
+static void iconv_cache_clear(struct iconv_cache *c)
+{
+  if (c->cd != (iconv_t) -1 && c->tocode)
+    iconv_close(c->cd);
+  FREE(&c->tocode);
+  FREE(&c->fromcode);
+  c->cd = (iconv_t) -1;
+  c->busy = 0;
+  c->stale = 0;
+}
+
+iconv_t mutt_iconv_open(const char *tocode, const char *fromcode, int flags)
+{
+  struct iconv_cache *c, *slot = NULL;
+  iconv_t cd;
+  int i;
+
+  for (i = 0; i < ICONV_CACHE_SIZE; i++)
+  {
+    c = &IconvCache[i];
+    if (!c->tocode)
+    {
+      if (!slot)
+        slot = c;
+      continue;
+    }
+    if (c->busy)
+      continue;
+    if (c->flags == flags &&
+        !mutt_strcmp(c->tocode, tocode) &&
+        !mutt_strcmp(c->fromcode, fromcode))
+    {
+      c->used = ++IconvCacheClock;
+      if (c->cd == (iconv_t) -1)
+        return (iconv_t) -1;
+      iconv(c->cd, NULL, NULL, NULL, NULL);
+      c->busy = 1;
+      return c->cd;
+    }
+    if (!slot || (slot->tocode && c->used < slot->used))
+      slot = c;
+  }
+
+  cd = charset_iconv_open(tocode, fromcode, flags);
+
+  /* don't remember failures that may be transient */
+  if (!slot || !tocode || !fromcode ||
+      (cd == (iconv_t) -1 && errno != EINVAL))
+    return cd;
+
+  iconv_cache_clear(slot);
+  slot->tocode = safe_strdup(tocode);
+  slot->fromcode = safe_strdup(fromcode);
+  slot->flags = flags;
+  slot->cd = cd;
+  slot->busy = (cd != (iconv_t) -1);
+  slot->used = ++IconvCacheClock;
+
+  return cd;
+}
+
+/* Releases a descriptor obtained from mutt_iconv_open() */
+void mutt_iconv_close(iconv_t cd)
+{
+  struct iconv_cache *c;
+  int i;
+
+  if (cd == (iconv_t) -1)
+    return;
+
+  for (i = 0; i < ICONV_CACHE_SIZE; i++)
+  {
+    c = &IconvCache[i];
+    if (c->busy && c->cd == cd)
+    {
+      c->busy = 0;
+      if (c->stale)
+        iconv_cache_clear(c);
+      return;
+    }
+  }
+
+  iconv_close(cd);
+}
+
+/* Forgets all cached descriptors, e.g. because a charset-hook or
+ * iconv-hook changed.  Descriptors still in use are closed when they
+ * are released. */
+void mutt_iconv_cache_flush(void)
+{
+  int i;
+
+  for (i = 0; i < ICONV_CACHE_SIZE; i++)
+  {
+    if (IconvCache[i].busy)
+      IconvCache[i].stale = 1;
+    else
+      iconv_cache_clear(&IconvCache[i]);
+  }
+}
+
 
 /*
  * Like iconv, but keeps going even when the input is invalid
@@ -476,6 +602,81 @@ size_t mutt_iconv(iconv_t cd, ICONV_CONST char **inbuf, size_t *inbytesleft,
  * for its meaning and usage policy.
  */
 
+/* returns 1 if s holds only valid UTF-8 */
+static int is_valid_utf8(const unsigned char *s)
+{
+  static const unsigned int min[] = { 0, 0x80, 0x800, 0x10000 };
+  int i, n;
+  unsigned int c;
+
+  while (*s)
+  {
+    if (*s < 0x80)
+    {
+      s++;
+      continue;
+    }
+    else if ((*s & 0xe0) == 0xc0)
+    {
+      n = 1;
+      c = *s & 0x1f;
+    }
+    else if ((*s & 0xf0) == 0xe0)
+    {
+      n = 2;
+      c = *s & 0x0f;
+    }
+    else if ((*s & 0xf8) == 0xf0)
+    {
+      n = 3;
+      c = *s & 0x07;
+    }
+    else
+      return 0;
+
+    for (i = 0, s++; i < n; i++, s++)
+    {
+      if ((*s & 0xc0) != 0x80)
+        return 0;
+      c = (c << 6) | (*s & 0x3f);
+    }
+
+    /* overlong forms, surrogates and values beyond U+10FFFF */
+    if (c < min[n] || (c >= 0xd800 && c <= 0xdfff) || c > 0x10ffff)
+      return 0;
+  }
+
+  return 1;
+}
+
+/*
+ * Converting between us-ascii and utf-8 doesn't change ASCII text, and
+ * converting valid UTF-8 to utf-8 doesn't change anything.  Recognise
+ * those cases so that mutt_convert_string() can skip iconv.
+ */
+static int convert_is_noop(const char *s, const char *from, const char *to,
+                           int flags)
+{
+  char fromcode[SHORT_STRING];
+  const char *p;
+  int to_utf8;
+
+  if (!(to_utf8 = mutt_is_utf8(to)) && !mutt_is_us_ascii(to))
+    return 0;
+
+  mutt_canonical_charset(fromcode, sizeof(fromcode), from);
+  if ((flags & MUTT_ICONV_HOOK_FROM) && (p = mutt_charset_hook(fromcode)))
+    mutt_canonical_charset(fromcode, sizeof(fromcode), p);
+
+  for (p = s; *p && !(*p & 0x80); p++)
+    ;
+  if (!*p)
+    return mutt_is_utf8(fromcode) || mutt_is_us_ascii(fromcode);
+
+  return to_utf8 && mutt_is_utf8(fromcode) &&
+    is_valid_utf8((const unsigned char *) p);
+}
+
 int mutt_convert_string(char **ps, const char *from, const char *to, int flags)
 {
   iconv_t cd;
@@ -485,6 +686,9 @@ int mutt_convert_string(char **ps, const char *from, const char *to, int flags)
   if (!s || !*s)
     return 0;
 
+  if (to && from && convert_is_noop(s, from, to, flags))
+    return 0;
+
   if (to && from && (cd = mutt_iconv_open(to, from, flags)) != (iconv_t)-1)
   {
     ICONV_CONST char *ib;
@@ -504,7 +708,7 @@ int mutt_convert_string(char **ps, const char *from, const char *to, int flags)
     ibl = strlen(s);
     if (ibl >= SIZE_MAX / MB_LEN_MAX)
     {
-      iconv_close(cd);
+      mutt_iconv_close(cd);
       return -1;
     }
 
@@ -513,7 +717,7 @@ int mutt_convert_string(char **ps, const char *from, const char *to, int flags)
 
     mutt_iconv(cd, &ib, &ibl, &ob, &obl, inrepls, outrepl);
     iconv(cd, 0, 0, &ob, &obl);
-    iconv_close(cd);
+    mutt_iconv_close(cd);
 
     *ob = '\0';
 
@@ -601,6 +805,41 @@ char *fgetconvs(char *buf, size_t l, FGETCONV *_fc)
     return NULL;
 }
 
+/* Reads up to l converted bytes into buf, without the NUL termination
+ * and line splitting of fgetconvs().  Returns the number of bytes read,
+ * 0 at the end of the input.
+ */
+size_t fgetconv_read(char *buf, size_t l, FGETCONV *_fc)
+{
+  struct fgetconv_s *fc = (struct fgetconv_s *)_fc;
+  size_t r = 0, n;
+  int c;
+
+  if (!fc)
+    return 0;
+  if (fc->cd == (iconv_t)-1)
+    return fread(buf, 1, l, fc->file);
+
+  while (r < l)
+  {
+    /* copy out what has already been converted, and let
+     * fgetconv() refill the output buffer */
+    if (fc->p && fc->p < fc->ob)
+    {
+      n = MIN(l - r, (size_t)(fc->ob - fc->p));
+      memcpy(buf + r, fc->p, n);
+      fc->p += n;
+      r += n;
+      continue;
+    }
+    if ((c = fgetconv(_fc)) == EOF)
+      break;
+    buf[r++] = (char) c;
+  }
+
+  return r;
+}
+
 int fgetconv(FGETCONV *_fc)
 {
   struct fgetconv_s *fc = (struct fgetconv_s *)_fc;
@@ -659,7 +898,7 @@ void fgetconv_close(FGETCONV **_fc)
   struct fgetconv_s *fc = (struct fgetconv_s *) *_fc;
 
   if (fc->cd != (iconv_t)-1)
-    iconv_close(fc->cd);
+    mutt_iconv_close(fc->cd);
   FREE(_fc);           /* __FREE_CHECKED__ */
 }
 
@@ -681,7 +920,7 @@ int mutt_check_charset(const char *s, int strict)
 
   if ((cd = mutt_iconv_open(s, s, 0)) != (iconv_t)(-1))
   {
-    iconv_close(cd);
+    mutt_iconv_close(cd);
     return 0;
   }
 
@@ -721,10 +721,7 @@ static int _mutt_parse_uncolor(BUFFER *buf, BUFFER *s, BUFFER *err, short parse_
     mutt_set_menu_redraw_full(MENU_MAIN);
     /* force re-caching of index colors */
     for (i = 0; Context && i < Context->msgcount; i++)
-    {
-      Context->hdrs[i]->color.pair = 0;
-      Context->hdrs[i]->color.attrs = 0;
-    }
+      Context->hdrs[i]->color_valid = 0;
   }
   return (0);
 }
@@ -820,10 +817,7 @@ add_pattern(COLOR_LINE **top, const char *s, int sensitive,
     int i;
 
     for (i = 0; Context && i < Context->msgcount; i++)
-    {
-      Context->hdrs[i]->color.pair = 0;
-      Context->hdrs[i]->color.attrs = 0;
-    }
+      Context->hdrs[i]->color_valid = 0;
   }
 
   return 0;
@@ -287,7 +287,8 @@ int mutt_display_message(HEADER *cur)
 
     /* Remove color cache for this message, in case there
        are color patterns for both ~g and ~V */
-    cur->color.pair = cur->color.attrs = 0;
+    cur->color_valid = 0;
+    mutt_invalidate_index_lines();
 
     /* Process protected headers and autocrypt gossip headers */
     process_protected_headers(cur);
@@ -35,6 +35,9 @@
 #include <ctype.h>
 #include <unistd.h> /* needed for SEEK_SET under SunOS 4.1.4 */
 
+/* bodies at least this large show progress while decoded for display */
+#define DECODE_PROGRESS_MIN (1024 * 1024)
+
 static int address_header_decode(char **str);
 static int copy_delete_attach(BODY *b, FILE *fpin, FILE *fpout, const char *date);
 
@@ -551,6 +554,7 @@ _mutt_copy_message(FILE *fpout, FILE *fpin, HEADER *hdr, BODY *body,
 {
   char prefix[SHORT_STRING];
   STATE s;
+  progress_t progress;
   LOFF_T new_offset = -1;
   int rc = 0;
 
@@ -636,6 +640,8 @@ _mutt_copy_message(FILE *fpout, FILE *fpin, HEADER *hdr, BODY *body,
 
         body->length = new_length;
         mutt_free_body(&body->parts);
+        FREE(&hdr->mime_skel);
+        hdr->attach_valid = 0;
       }
 
       attach_del_rc = 0;
@@ -676,7 +682,21 @@ _mutt_copy_message(FILE *fpout, FILE *fpin, HEADER *hdr, BODY *body,
     if (WithCrypto && flags & MUTT_CM_VERIFY)
       s.flags |= MUTT_VERIFY;
 
+    /* decoding a large message for display can take a while, so let
+     * the user see that something is happening */
+    if ((flags & MUTT_CM_DISPLAY) && NetInc > 0 &&
+        body->length >= DECODE_PROGRESS_MIN)
+    {
+      mutt_progress_init(&progress, _("Decoding message..."),
+                         MUTT_PROGRESS_SIZE, NetInc, body->length);
+      s.progress = &progress;
+      s.progress_offset = body->offset;
+    }
+
     rc = mutt_body_handler(body, &s);
+
+    if (s.progress)
+      mutt_clear_error();
   }
   else if (WithCrypto
            && (flags & MUTT_CM_DECODE_CRYPT) && (hdr->security & ENCRYPT))
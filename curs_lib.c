@@ -849,6 +849,8 @@ void mutt_reflow_windows(void)
 
   muttdbg(2, "In mutt_reflow_windows");
 
+  mutt_invalidate_index_lines();
+
   MuttStatusWindow->rows = 1;
   MuttStatusWindow->cols = COLS;
   MuttStatusWindow->row_offset = option(OPTSTATUSONTOP) ? 0 : LINES - 2;
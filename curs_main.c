@@ -129,6 +129,13 @@ static const char *No_visible = N_("No visible messages.");
 #define OLDHDR Context->hdrs[Context->v2r[menu->oldcurrent]]
 #define UNREAD(h) mutt_thread_contains_unread(Context, h)
 
+/* see mutt_invalidate_index_lines() */
+static unsigned int IndexGeneration = 1;
+
+/* whether $index_format lines may be cached, as of IndexFormatGeneration */
+static unsigned int IndexFormatGeneration = 0;
+static int IndexFormatCacheable = 0;
+
 /* de facto standard escapes for tsl/fsl */
 static char *tsl = "\033]0;";
 static char *fsl = "\007";
@@ -267,14 +274,48 @@ void index_make_entry(char *s, size_t l, MUTTMENU *menu, int num)
     }
   }
 
+  /* Any change to $index_format bumps IndexGeneration, so the format
+   * only has to be looked at again then.  %<fmt> expands to the current
+   * time, and an %@name@ index-format-hook may match on it, e.g. with
+   * ~d<1d, so lines using either can't be cached. */
+  if (IndexFormatGeneration != IndexGeneration)
+  {
+    IndexFormatCacheable = !strstr(NONULL(HdrFmt), "%<") &&
+                           !strstr(NONULL(HdrFmt), "%@");
+    IndexFormatGeneration = IndexGeneration;
+  }
+
+  if (IndexFormatCacheable && h->index_line &&
+      h->index_line_gen == IndexGeneration && h->index_line_flags == flag)
+  {
+    strfcpy(s, h->index_line, l);
+    return;
+  }
+
   _mutt_make_string(s, l, NONULL(HdrFmt), Context, h, flag);
+
+  if (IndexFormatCacheable)
+  {
+    mutt_str_replace(&h->index_line, s);
+    h->index_line_gen = IndexGeneration;
+    h->index_line_flags = flag;
+  }
+}
+
+/* Called whenever something an $index_format expansion can depend on
+ * changes: flags, threading, sorting, limits, options, screen width.
+ * All cached index lines become stale at once.
+ */
+void mutt_invalidate_index_lines(void)
+{
+  IndexGeneration++;
 }
 
 COLOR_ATTR index_color(int index_no)
 {
   HEADER *h = Context->hdrs[Context->v2r[index_no]];
 
-  if (h && (h->color.pair || h->color.attrs))
+  if (h && h->color_valid)
     return h->color;
 
   mutt_set_header_color(Context, h);
@@ -2720,16 +2761,17 @@ int mutt_index_menu(void)
 void mutt_set_header_color(CONTEXT *ctx, HEADER *curhdr)
 {
   COLOR_LINE *color_line;
-  pattern_cache_t cache;
+  pattern_cache_t *cache;
 
   if (!curhdr)
     return;
 
-  memset(&cache, 0, sizeof(cache));
+  cache = mutt_header_pattern_cache(curhdr);
+  curhdr->color_valid = 1;
 
   for (color_line = ColorIndexList; color_line; color_line = color_line->next)
     if (mutt_pattern_exec(color_line->color_pattern, MUTT_MATCH_FULL_ADDRESS,
-                          ctx, curhdr, &cache))
+                          ctx, curhdr, cache))
     {
       curhdr->color = color_line->color;
       return;
@@ -38,6 +38,8 @@ void _mutt_set_flag(CONTEXT *ctx, HEADER *h, int flag, int bf, int upd_flags)
   if (ctx->readonly && flag != MUTT_TAG)
     return; /* don't modify anything if we are read-only */
 
+  mutt_invalidate_index_lines();
+
   switch (flag)
   {
     case MUTT_DELETE:
@@ -273,8 +275,7 @@ void _mutt_set_flag(CONTEXT *ctx, HEADER *h, int flag, int bf, int upd_flags)
 
   if (update)
   {
-    h->color.pair = 0;
-    h->color.attrs = 0;
+    h->color_valid = 0;
 #ifdef USE_SIDEBAR
     mutt_set_current_menu_redraw(REDRAW_SIDEBAR);
 #endif
@@ -321,7 +322,7 @@ int mutt_thread_set_flag(HEADER *hdr, int flag, int bf, int subthread)
   if (cur->message)
   {
     mutt_set_flag(Context, cur->message, flag, bf);
-    cur->message->color.pair = cur->message->color.attrs = 0;
+    cur->message->color_valid = 0;
   }
 
   if ((cur = cur->child) == NULL)
@@ -332,7 +333,7 @@ int mutt_thread_set_flag(HEADER *hdr, int flag, int bf, int subthread)
     if (cur->message)
     {
       mutt_set_flag(Context, cur->message, flag, bf);
-      cur->message->color.pair = cur->message->color.attrs = 0;
+      cur->message->color_valid = 0;
     }
 
     if (cur->child)
@@ -98,11 +98,11 @@ WHERE char *MhReplied;
 WHERE char *MhUnseen;
 WHERE char *MimeTypeQueryCmd;
 WHERE char *MsgFmt;
+WHERE short NetInc;
 
 #ifdef USE_SOCKET
 WHERE char *Preconnect;
 WHERE char *Tunnel;
-WHERE short NetInc;
 WHERE short SocketReceiveTimeout;
 WHERE short SocketSendTimeout;
 #endif /* USE_SOCKET */
@@ -231,6 +231,12 @@ extern unsigned char QuadOptions[];
 
 WHERE unsigned short Counter;
 
+/* bumped to invalidate HEADER->pattern_cache, see mutt_header_pattern_cache() */
+WHERE unsigned int PatternCacheGeneration INITVAL(1);
+
+/* bumped whenever an RX_LIST or REPLACE_LIST is modified */
+WHERE unsigned int RxListGeneration INITVAL(1);
+
 WHERE short ConnectTimeout;
 WHERE short ErrorHistSize;
 WHERE short HistSize;
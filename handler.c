@@ -139,7 +139,10 @@ static void mutt_decode_xbit(STATE *s, LOFF_T len, int istext, iconv_t cd)
 
       bufi[l++] = c;
       if (l == sizeof(bufi))
+      {
         mutt_convert_to_state(cd, bufi, &l, s);
+        state_update_progress(s);
+      }
     }
 
     mutt_convert_to_state(cd, bufi, &l, s);
@@ -183,6 +186,18 @@ static void qp_decode_line(char *dest, char *src, size_t *l,
 
   for (d = dest, s = src; *s;)
   {
+    /* copy runs without any quoting in one go */
+    if (*s != '=')
+    {
+      size_t n = strcspn(s, "=");
+
+      memcpy(d, s, n);
+      d += n;
+      s += n;
+      kind = -1;
+      continue;
+    }
+
     switch ((kind = qp_decode_triple(s, &c)))
     {
       case  0: *d++ = c; s += 3; break; /* qp triple */
@@ -259,6 +274,7 @@ static void mutt_decode_quoted(STATE *s, LOFF_T len, int istext, iconv_t cd)
 
     linelen = strlen(line);
     len -= linelen;
+    state_update_progress(s);
 
     /*
      * inspect the last character we read so we can tell if we got the
@@ -284,81 +300,83 @@ static void mutt_decode_quoted(STATE *s, LOFF_T len, int istext, iconv_t cd)
   state_reset_prefix(s);
 }
 
+/* Appends one decoded byte to bufi, turning CRLF into LF for text. */
+static void b64_decode_put(char ch, int istext, int *cr, char *bufi, size_t *l)
+{
+  if (*cr && ch != '\n')
+    bufi[(*l)++] = '\r';
+
+  *cr = 0;
+
+  if (istext && ch == '\r')
+    *cr = 1;
+  else
+    bufi[(*l)++] = ch;
+}
+
+/*
+ * The input is read in blocks rather than with one fgetc() per
+ * character.  Characters outside the base64 alphabet (line breaks,
+ * whitespace) are skipped, and decoding stops at the first pad.
+ */
 void mutt_decode_base64(STATE *s, LOFF_T len, int istext, iconv_t cd)
 {
-  char buf[5];
-  int c1, c2, c3, c4, ch, cr = 0, i;
+  unsigned char bufin[4 * BUFI_SIZE];
+  char buf[4];
+  int c1, c2, c3, c4, ch, cr = 0, i = 0, done = 0;
   char bufi[BUFI_SIZE];
-  size_t l = 0;
-
-  buf[4] = 0;
+  size_t l = 0, n, pos;
 
   if (istext)
     state_set_prefix(s);
 
-  while (len > 0)
+  while (len > 0 && !done)
   {
-    for (i = 0 ; i < 4 && len > 0 ; len--)
-    {
-      if ((ch = fgetc(s->fpin)) == EOF)
-        break;
-      if (ch >= 0 && ch < 128 && (base64val(ch) != -1 || ch == '='))
-        buf[i++] = ch;
-    }
-    if (i != 4)
-    {
-      /* "i" may be zero if there is trailing whitespace, which is not an error */
-      if (i != 0)
-        muttdbg(2, "didn't get a multiple of 4 chars.");
+    n = fread(bufin, 1, MIN((LOFF_T) sizeof(bufin), len), s->fpin);
+    if (!n)
       break;
-    }
-
-    c1 = base64val(buf[0]);
-    c2 = base64val(buf[1]);
-    ch = (c1 << 2) | (c2 >> 4);
+    len -= n;
+    state_update_progress(s);
 
-    if (cr && ch != '\n')
-      bufi[l++] = '\r';
-
-    cr = 0;
-
-    if (istext && ch == '\r')
-      cr = 1;
-    else
-      bufi[l++] = ch;
-
-    if (buf[2] == '=')
-      break;
-    c3 = base64val(buf[2]);
-    ch = ((c2 & 0xf) << 4) | (c3 >> 2);
-
-    if (cr && ch != '\n')
-      bufi[l++] = '\r';
-
-    cr = 0;
-
-    if (istext && ch == '\r')
-      cr = 1;
-    else
-      bufi[l++] = ch;
-
-    if (buf[3] == '=') break;
-    c4 = base64val(buf[3]);
-    ch = ((c3 & 0x3) << 6) | c4;
-
-    if (cr && ch != '\n')
-      bufi[l++] = '\r';
-    cr = 0;
+    for (pos = 0; pos < n; pos++)
+    {
+      ch = bufin[pos];
+      if (ch >= 128 || (base64val(ch) == -1 && ch != '='))
+        continue;
+      buf[i++] = ch;
+      if (i < 4)
+        continue;
+      i = 0;
+
+      c1 = base64val(buf[0]);
+      c2 = base64val(buf[1]);
+      b64_decode_put((c1 << 2) | (c2 >> 4), istext, &cr, bufi, &l);
+
+      if (buf[2] == '=')
+      {
+        done = 1;
+        break;
+      }
+      c3 = base64val(buf[2]);
+      b64_decode_put(((c2 & 0xf) << 4) | (c3 >> 2), istext, &cr, bufi, &l);
 
-    if (istext && ch == '\r')
-      cr = 1;
-    else
-      bufi[l++] = ch;
+      if (buf[3] == '=')
+      {
+        done = 1;
+        break;
+      }
+      c4 = base64val(buf[3]);
+      b64_decode_put(((c3 & 0x3) << 6) | c4, istext, &cr, bufi, &l);
 
-    if (l + 8 >= sizeof(bufi))
-      mutt_convert_to_state(cd, bufi, &l, s);
+      if (l + 8 >= sizeof(bufi))
+        mutt_convert_to_state(cd, bufi, &l, s);
+    }
   }
 
+  /* "i" may be zero if there is trailing whitespace, which is not an error */
+  if (!done && i != 0)
+    muttdbg(2, "didn't get a multiple of 4 chars.");
+
   if (cr) bufi[l++] = '\r';
 
   mutt_convert_to_state(cd, bufi, &l, s);
@@ -400,6 +418,7 @@ static void mutt_decode_uuencoded(STATE *s, LOFF_T len, int istext, iconv_t cd)
     len -= mutt_strlen(tmps);
     if (!mutt_strncmp(tmps, "end", 3))
       break;
+    state_update_progress(s);
     pt = tmps;
     linelen = decode_byte(*pt);
     pt++;
@@ -1582,7 +1601,7 @@ void mutt_decode_attachment(const BODY *b, STATE *s)
   }
 
   if (cd != (iconv_t)(-1))
-    iconv_close(cd);
+    mutt_iconv_close(cd);
 }
 
 /* when generating format=flowed ($text_flowed is set) from format=fixed,
@@ -1606,6 +1625,7 @@ static int text_plain_handler(BODY *b, STATE *s)
       state_puts(s->prefix, s);
     state_puts(buf, s);
     state_putc('\n', s);
+    state_update_progress(s);
   }
 
   FREE(&buf);
@@ -1911,6 +1931,7 @@ int mutt_body_handler(BODY *b, STATE *s)
 cleanup:
   recurse_level--;
   s->flags = oflags | (s->flags & MUTT_FIRSTDONE);
+  state_update_progress(s);
   if (rc)
   {
     muttdbg(1, "Bailing on attachment of type %s/%s.", TYPE(b), NONULL(b->subtype));
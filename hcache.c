@@ -42,6 +42,7 @@
 #include <lmdb.h>
 #endif
 
+#include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <sys/time.h>
@@ -54,35 +55,61 @@
 #include "rfc822.h"
 #include "url.h"
 
+/* A batch opened with mutt_hcache_begin() is flushed early once it holds
+ * this many records or bytes, which keeps an LMDB write transaction from
+ * growing without bound during the initial sync of a large folder. */
+#define HCACHE_BATCH_RECORDS    1000
+#define HCACHE_BATCH_BYTES      (4 * 1024 * 1024)
+
 unsigned int hcachever = 0x0;
 
+/* Header lookups made this session, reported by header-cache-gc */
+static unsigned int HcacheFetches = 0;
+static unsigned int HcacheHits = 0;
+
 #if HAVE_QDBM
 struct header_cache
 {
   VILLA *db;
   char *folder;
+  char *path;
   unsigned int crc;
+  int batch;
+  unsigned int batch_count;
+  size_t batch_size;
 };
 #elif HAVE_TC
 struct header_cache
 {
   TCBDB *db;
   char *folder;
+  char *path;
   unsigned int crc;
+  int batch;
+  unsigned int batch_count;
+  size_t batch_size;
 };
 #elif HAVE_KC
 struct header_cache
 {
   KCDB *db;
   char *folder;
+  char *path;
   unsigned int crc;
+  int batch;
+  unsigned int batch_count;
+  size_t batch_size;
 };
 #elif HAVE_GDBM
 struct header_cache
 {
   GDBM_FILE db;
   char *folder;
+  char *path;
   unsigned int crc;
+  int batch;
+  unsigned int batch_count;
+  size_t batch_size;
 };
 #elif HAVE_DB4
 struct header_cache
@@ -90,7 +117,11 @@ struct header_cache
   DB_ENV *env;
   DB *db;
   char *folder;
+  char *path;
   unsigned int crc;
+  int batch;
+  unsigned int batch_count;
+  size_t batch_size;
   int fd;
   BUFFER *lockfile;
 };
@@ -110,7 +141,11 @@ struct header_cache
   MDB_txn *txn;
   MDB_dbi db;
   char *folder;
+  char *path;
   unsigned int crc;
+  int batch;
+  unsigned int batch_count;
+  size_t batch_size;
   enum mdb_txn_mode txn_mode;
 };
 
@@ -174,32 +209,39 @@ typedef union
   unsigned int uidvalidity;
 } validate;
 
-static void *
-lazy_malloc(size_t siz)
-{
-  if (0 < siz && siz < 4096)
-    siz = 4096;
+/* mutt_hcache_dump() serializes into this buffer.  It is kept between
+ * calls and grows geometrically, so storing a header doesn't reallocate
+ * for every field. */
+static unsigned char *DumpBuf = NULL;
+static size_t DumpBufLen = 0;
 
-  return safe_malloc(siz);
-}
-
-static void
-lazy_realloc(void *ptr, size_t siz)
+/* Makes room for len more bytes at off.  d is always DumpBuf. */
+static unsigned char *
+dump_reserve(unsigned char *d, int off, size_t len)
 {
-  void **p = (void **) ptr;
+  if (off + len <= DumpBufLen)
+    return d;
 
-  if (p != NULL && 0 < siz && siz < 4096)
-    return;
+  DumpBufLen = MAX(DumpBufLen * 2, 4096);
+  while (off + len > DumpBufLen)
+    DumpBufLen *= 2;
+  safe_realloc(&DumpBuf, DumpBufLen);
 
-  safe_realloc(ptr, siz);
+  return DumpBuf;
 }
 
+/* Integers are stored as varints: 7 bits per byte, least significant
+ * first, with the high bit set on all but the last byte. */
 static unsigned char *
 dump_int(unsigned int i, unsigned char *d, int *off)
 {
-  lazy_realloc(&d, *off + sizeof(int));
-  memcpy(d + *off, &i, sizeof(int));
-  (*off) += sizeof(int);
+  d = dump_reserve(d, *off, 5);
+  while (i >= 0x80)
+  {
+    d[(*off)++] = (i & 0x7f) | 0x80;
+    i >>= 7;
+  }
+  d[(*off)++] = i;
 
   return d;
 }
@@ -207,8 +249,19 @@ dump_int(unsigned int i, unsigned char *d, int *off)
 static void
 restore_int(unsigned int *i, const unsigned char *d, int *off)
 {
-  memcpy(i, d + *off, sizeof(int));
-  (*off) += sizeof(int);
+  unsigned int v = 0;
+  int shift = 0;
+  unsigned char c;
+
+  do
+  {
+    c = d[(*off)++];
+    v |= (unsigned int) (c & 0x7f) << shift;
+    shift += 7;
+  }
+  while ((c & 0x80) && shift < 35);
+
+  *i = v;
 }
 
 static inline int is_ascii(const char *p, size_t len)
@@ -226,7 +279,7 @@ static inline int is_ascii(const char *p, size_t len)
 static unsigned char *
 dump_char_size(char *c, unsigned char *d, int *off, ssize_t size, int convert)
 {
-  char *p = c;
+  char *p = NULL;
 
   if (c == NULL)
   {
@@ -246,12 +299,11 @@ dump_char_size(char *c, unsigned char *d, int *off, ssize_t size, int convert)
   }
 
   d = dump_int(size, d, off);
-  lazy_realloc(&d, *off + size);
-  memcpy(d + *off, p, size);
+  d = dump_reserve(d, *off, size);
+  memcpy(d + *off, c, size);
   *off += size;
 
-  if (p != c)
-    FREE(&p);
+  FREE(&p);
 
   return d;
 }
@@ -295,9 +347,11 @@ static unsigned char *
 dump_address(ADDRESS * a, unsigned char *d, int *off, int convert)
 {
   unsigned int counter = 0;
-  unsigned int start_off = *off;
+  ADDRESS *tmp;
 
-  d = dump_int(0xdeadbeef, d, off);
+  for (tmp = a; tmp; tmp = tmp->next)
+    counter++;
+  d = dump_int(counter, d, off);
 
   while (a)
   {
@@ -308,11 +362,8 @@ dump_address(ADDRESS * a, unsigned char *d, int *off, int convert)
     d = dump_char(a->mailbox, d, off, 0);
     d = dump_int(a->group, d, off);
     a = a->next;
-    counter++;
   }
 
-  memcpy(d + start_off, &counter, sizeof(int));
-
   return d;
 }
 
@@ -343,19 +394,18 @@ static unsigned char *
 dump_list(LIST * l, unsigned char *d, int *off, int convert)
 {
   unsigned int counter = 0;
-  unsigned int start_off = *off;
+  LIST *tmp;
 
-  d = dump_int(0xdeadbeef, d, off);
+  for (tmp = l; tmp; tmp = tmp->next)
+    counter++;
+  d = dump_int(counter, d, off);
 
   while (l)
   {
     d = dump_char(l->data, d, off, convert);
     l = l->next;
-    counter++;
   }
 
-  memcpy(d + start_off, &counter, sizeof(int));
-
   return d;
 }
 
@@ -419,20 +469,19 @@ static unsigned char *
 dump_parameter(PARAMETER * p, unsigned char *d, int *off, int convert)
 {
   unsigned int counter = 0;
-  unsigned int start_off = *off;
+  PARAMETER *tmp;
 
-  d = dump_int(0xdeadbeef, d, off);
+  for (tmp = p; tmp; tmp = tmp->next)
+    counter++;
+  d = dump_int(counter, d, off);
 
   while (p)
   {
     d = dump_char(p->attribute, d, off, 0);
     d = dump_char(p->value, d, off, convert);
     p = p->next;
-    counter++;
   }
 
-  memcpy(d + start_off, &counter, sizeof(int));
-
   return d;
 }
 
@@ -471,7 +520,7 @@ dump_body(BODY * c, unsigned char *d, int *off, int convert)
   nb.aptr = NULL;
   nb.mime_headers = NULL;
 
-  lazy_realloc(&d, *off + sizeof(BODY));
+  d = dump_reserve(d, *off, sizeof(BODY));
   memcpy(d + *off, &nb, sizeof(BODY));
   *off += sizeof(BODY);
 
@@ -581,13 +630,12 @@ restore_envelope(ENVELOPE * e, const unsigned char *d, int *off, int convert)
 static int
 crc_matches(const char *d, unsigned int crc)
 {
-  int off = sizeof(validate);
   unsigned int mycrc = 0;
 
   if (!d)
     return 0;
 
-  restore_int(&mycrc, (const unsigned char *) d, &off);
+  memcpy(&mycrc, d + sizeof(validate), sizeof(mycrc));
 
   return (crc == mycrc);
 }
@@ -675,18 +723,22 @@ mutt_hcache_per_folder(BUFFER *hcpath, const char *path, const char *folder,
 }
 
 /* This function transforms a header into a char so that it is usable by
- * db_store.
+ * db_store.  The returned data is only valid until the next call.
+ *
+ * The validate data and crc are stored as is, so they can be checked
+ * without decoding the record, and are followed by the HEADER.  All other
+ * integers are varints.
  */
 static void *
 mutt_hcache_dump(header_cache_t *h, HEADER * header, int *off,
                  unsigned int uidvalidity, mutt_hcache_store_flags_t flags)
 {
-  unsigned char *d = NULL;
+  unsigned char *d = DumpBuf;
   HEADER nh;
   int convert = !Charset_is_utf8;
 
   *off = 0;
-  d = lazy_malloc(sizeof(validate));
+  d = dump_reserve(d, 0, sizeof(validate) + sizeof(unsigned int) + sizeof(HEADER));
 
   if (flags & MUTT_GENERATE_UIDVALIDITY)
   {
@@ -698,9 +750,9 @@ mutt_hcache_dump(header_cache_t *h, HEADER * header, int *off,
     memcpy(d, &uidvalidity, sizeof(uidvalidity));
   *off += sizeof(validate);
 
-  d = dump_int(h->crc, d, off);
+  memcpy(d + *off, &h->crc, sizeof(h->crc));
+  *off += sizeof(h->crc);
 
-  lazy_realloc(&d, *off + sizeof(HEADER));
   memcpy(&nh, header, sizeof(HEADER));
 
   /* some fields are not safe to cache */
@@ -716,10 +768,16 @@ mutt_hcache_dump(header_cache_t *h, HEADER * header, int *off,
   nh.recipient = 0;
   nh.color.pair = 0;
   nh.color.attrs = 0;
-  nh.attach_valid = 0;
+  nh.color_valid = 0;
+  memset(&nh.pattern_cache, 0, sizeof(pattern_cache_t));
+  nh.pattern_cache_gen = 0;
+  nh.mime_skel = NULL;
+  nh.mime_skel_dirty = 0;
   nh.path = NULL;
   nh.tree = NULL;
   nh.thread = NULL;
+  nh.index_line = NULL;
+  nh.index_line_gen = 0;
 #ifdef MIXMASTER
   nh.chain = NULL;
 #endif
@@ -734,6 +792,10 @@ mutt_hcache_dump(header_cache_t *h, HEADER * header, int *off,
   d = dump_body(nh.content, d, off, convert);
   d = dump_char(nh.maildir_flags, d, off, convert);
 
+  /* attachment counts are only valid for the rules they were made with */
+  d = dump_char(header->mime_skel, d, off, 0);
+  d = dump_int(mutt_attach_rules_hash(), d, off);
+
   return d;
 }
 
@@ -743,6 +805,7 @@ mutt_hcache_restore(const unsigned char *d, HEADER ** oh)
   int off = 0;
   HEADER *h = mutt_new_header();
   int convert = !Charset_is_utf8;
+  unsigned int rules_hash = 0;
 
   /* skip validate */
   off += sizeof(validate);
@@ -761,6 +824,11 @@ mutt_hcache_restore(const unsigned char *d, HEADER ** oh)
 
   restore_char(&h->maildir_flags, d, &off, convert);
 
+  restore_char(&h->mime_skel, d, &off, 0);
+  restore_int(&rules_hash, d, &off);
+  if (rules_hash != mutt_attach_rules_hash())
+    h->attach_valid = 0;
+
   /* this is needed for maildir style mailboxes */
   if (oh)
   {
@@ -778,6 +846,10 @@ mutt_hcache_fetch(header_cache_t *h, const char *filename,
 {
   void *data;
 
+  if (!h)
+    return NULL;
+
+  HcacheFetches++;
   data = mutt_hcache_fetch_raw(h, filename, keylen);
 
   if (!data || !crc_matches(data, h->crc))
@@ -786,6 +858,7 @@ mutt_hcache_fetch(header_cache_t *h, const char *filename,
     return NULL;
   }
 
+  HcacheHits++;
   return data;
 }
 
@@ -863,6 +936,80 @@ mutt_hcache_fetch_raw(header_cache_t *h, const char *filename,
 #endif
 }
 
+/* Writes out the records stored since the last flush.  LMDB commits its
+ * write transaction; the other backends already write each record as it
+ * is stored and only need an explicit sync when $header_cache_sync is
+ * set.  With LMDB and $header_cache_sync unset, the environment is opened
+ * with MDB_NOMETASYNC: each commit still syncs the data pages, but the
+ * meta page is only synced by the next commit or in mutt_hcache_close().
+ * A crash may then roll back the last commit, but it can't damage the
+ * database the way MDB_NOSYNC could. */
+static int hcache_flush(header_cache_t *h)
+{
+  int rc = 0;
+
+#if HAVE_LMDB
+  if (h->txn && h->txn_mode == txn_write)
+  {
+    if ((rc = mdb_txn_commit(h->txn)) != MDB_SUCCESS)
+      muttdbg(2, "mdb_txn_commit: %s", mdb_strerror(rc));
+    h->txn_mode = txn_uninitialized;
+    h->txn = NULL;
+  }
+#else
+  if (h->batch_count && option(OPTHCACHESYNC))
+  {
+#if HAVE_QDBM
+    rc = vlsync(h->db) ? 0 : -1;
+#elif HAVE_TC
+    rc = tcbdbsync(h->db) ? 0 : -1;
+#elif HAVE_KC
+    rc = kcdbsync(h->db, 1, NULL, NULL) ? 0 : -1;
+#elif HAVE_GDBM
+    gdbm_sync(h->db);
+#elif HAVE_DB4
+    rc = h->db->sync(h->db, 0);
+#endif
+  }
+#endif
+
+  h->batch_count = 0;
+  h->batch_size = 0;
+  return rc;
+}
+
+static void hcache_batch_add(header_cache_t *h, size_t dlen)
+{
+  h->batch_count++;
+  h->batch_size += dlen;
+
+  if (h->batch_count >= HCACHE_BATCH_RECORDS ||
+      h->batch_size >= HCACHE_BATCH_BYTES)
+    hcache_flush(h);
+}
+
+/* Groups the stores that follow until the matching mutt_hcache_commit().
+ * Calls may be nested; only the outermost commit flushes. */
+int mutt_hcache_begin(header_cache_t *h)
+{
+  if (!h)
+    return -1;
+
+  h->batch++;
+  return 0;
+}
+
+int mutt_hcache_commit(header_cache_t *h)
+{
+  if (!h || !h->batch)
+    return -1;
+
+  if (--h->batch)
+    return 0;
+
+  return hcache_flush(h);
+}
+
 /*
  * flags
  *
@@ -884,8 +1031,8 @@ mutt_hcache_store(header_cache_t *h, const char *filename, HEADER * header,
 
   data = mutt_hcache_dump(h, header, &dlen, uidvalidity, flags);
   ret = mutt_hcache_store_raw(h, filename, data, dlen, keylen);
-
-  FREE(&data);
+  if (!ret)
+    header->mime_skel_dirty = 0;
 
   return ret;
 }
@@ -897,8 +1044,8 @@ mutt_hcache_store_raw(header_cache_t *h, const char *filename, void *data,
 #ifndef HAVE_DB4
   BUFFER *path = NULL;
   int ksize;
-  int rv = 0;
 #endif
+  int rv = 0;
 #if HAVE_GDBM
   datum key;
   datum databuf;
@@ -925,7 +1072,9 @@ mutt_hcache_store_raw(header_cache_t *h, const char *filename, void *data,
   databuf.size = dlen;
   databuf.ulen = dlen;
 
-  return h->db->put(h->db, NULL, &key, &databuf, 0);
+  if ((rv = h->db->put(h->db, NULL, &key, &databuf, 0)) == 0)
+    hcache_batch_add(h, dlen);
+  return rv;
 
 #else
   path = mutt_buffer_pool_get();
@@ -965,6 +1114,9 @@ mutt_hcache_store_raw(header_cache_t *h, const char *filename, void *data,
   }
 #endif
 
+  if (rv == 0)
+    hcache_batch_add(h, dlen);
+
   mutt_buffer_pool_release(&path);
   return rv;
 #endif
@@ -1017,8 +1169,10 @@ mutt_hcache_close(header_cache_t *h)
   if (!h)
     return;
 
+  hcache_flush(h);
   vlclose(h->db);
   FREE(&h->folder);
+  FREE(&h->path);
   FREE(&h);
 }
 
@@ -1072,6 +1226,7 @@ mutt_hcache_close(header_cache_t *h)
   if (!h)
     return;
 
+  hcache_flush(h);
   if (!tcbdbclose(h->db))
   {
 #ifdef DEBUG
@@ -1081,6 +1236,7 @@ mutt_hcache_close(header_cache_t *h)
   }
   tcbdbdel(h->db);
   FREE(&h->folder);
+  FREE(&h->path);
   FREE(&h);
 }
 
@@ -1149,11 +1305,13 @@ mutt_hcache_close(header_cache_t *h)
   if (!h)
     return;
 
+  hcache_flush(h);
   if (!kcdbclose(h->db))
     muttdbg(2, "kcdbclose failed for %s: %s (ecode %d)", h->folder,
             kcdbemsg(h->db), kcdbecode(h->db));
   kcdbdel(h->db);
   FREE(&h->folder);
+  FREE(&h->path);
   FREE(&h);
 }
 
@@ -1207,8 +1365,10 @@ mutt_hcache_close(header_cache_t *h)
   if (!h)
     return;
 
+  hcache_flush(h);
   gdbm_close(h->db);
   FREE(&h->folder);
+  FREE(&h->path);
   FREE(&h);
 }
 
@@ -1322,6 +1482,7 @@ mutt_hcache_close(header_cache_t *h)
   if (!h)
     return;
 
+  hcache_flush(h);
   h->db->close(h->db, 0);
   h->env->close(h->env, 0);
   mx_unlock_file(mutt_b2s(h->lockfile), h->fd, 0);
@@ -1329,6 +1490,7 @@ mutt_hcache_close(header_cache_t *h)
   unlink(mutt_b2s(h->lockfile));
   mutt_buffer_free(&h->lockfile);
   FREE(&h->folder);
+  FREE(&h->path);
   FREE(&h);
 }
 
@@ -1365,7 +1527,9 @@ hcache_open_lmdb(struct header_cache *h, const char *path)
 
   mdb_env_set_mapsize(h->env, LMDB_DB_SIZE);
 
-  if ((rc = mdb_env_open(h->env, path, MDB_NOSUBDIR, 0644)) != MDB_SUCCESS)
+  if ((rc = mdb_env_open(h->env, path,
+                         MDB_NOSUBDIR | (option(OPTHCACHESYNC) ? 0 : MDB_NOMETASYNC),
+                         0644)) != MDB_SUCCESS)
   {
     muttdbg(2, "mdb_env_open: %s",
             mdb_strerror(rc));
@@ -1407,21 +1571,23 @@ mutt_hcache_close(header_cache_t *h)
   if (h->txn)
   {
     if (h->txn_mode == txn_write)
-    {
-      if ((rc = mdb_txn_commit(h->txn)) != MDB_SUCCESS)
-      {
-        muttdbg(2, "mdb_txn_commit: %s",
-                mdb_strerror(rc));
-      }
-    }
+      hcache_flush(h);
     else
+    {
       mdb_txn_abort(h->txn);
-    h->txn_mode = txn_uninitialized;
-    h->txn = NULL;
+      h->txn_mode = txn_uninitialized;
+      h->txn = NULL;
+    }
   }
 
+  /* with MDB_NOMETASYNC the meta page of the last commit isn't synced yet */
+  if (!option(OPTHCACHESYNC) &&
+      (rc = mdb_env_sync(h->env, 1)) != MDB_SUCCESS)
+    muttdbg(2, "mdb_env_sync: %s", mdb_strerror(rc));
+
   mdb_env_close(h->env);
   FREE(&h->folder);
+  FREE(&h->path);
   FREE(&h);
 }
 
@@ -1464,27 +1630,29 @@ cleanup:
 }
 #endif
 
-header_cache_t *
-mutt_hcache_open(const char *path, const char *folder, hcache_namer_t namer)
+static int hcache_open(struct header_cache *h, const char *path)
 {
-  struct header_cache *h = safe_calloc(1, sizeof(struct header_cache));
-  int (*hcache_open)(struct header_cache *h, const char *path);
-  struct stat sb;
-  BUFFER *hcpath = NULL;
-
 #if HAVE_QDBM
-  hcache_open = hcache_open_qdbm;
+  return hcache_open_qdbm(h, path);
 #elif HAVE_TC
-  hcache_open= hcache_open_tc;
+  return hcache_open_tc(h, path);
 #elif HAVE_KC
-  hcache_open= hcache_open_kc;
+  return hcache_open_kc(h, path);
 #elif HAVE_GDBM
-  hcache_open = hcache_open_gdbm;
+  return hcache_open_gdbm(h, path);
 #elif HAVE_DB4
-  hcache_open = hcache_open_db4;
+  return hcache_open_db4(h, path);
 #elif HAVE_LMDB
-  hcache_open = hcache_open_lmdb;
+  return hcache_open_lmdb(h, path);
 #endif
+}
+
+header_cache_t *
+mutt_hcache_open(const char *path, const char *folder, hcache_namer_t namer)
+{
+  struct header_cache *h = safe_calloc(1, sizeof(struct header_cache));
+  struct stat sb;
+  BUFFER *hcpath = NULL;
 
   /* Calculate the current hcache version from dynamic configuration */
   if (hcachever == 0x0)
@@ -1552,6 +1720,9 @@ mutt_hcache_open(const char *path, const char *folder, hcache_namer_t namer)
     }
   }
 
+  if (h)
+    h->path = safe_strdup(mutt_b2s(hcpath));
+
   mutt_buffer_pool_release(&hcpath);
   return h;
 }
@@ -1571,6 +1742,319 @@ void mutt_hcache_free(void **data)
 #endif
 }
 
+/* Returns the raw keys of up to max records (all of them if max is 0).
+ * The keys are collected first because most backends don't allow
+ * deleting records while a cursor walks the database. */
+static LIST *hcache_keys(header_cache_t *h, int max)
+{
+  LIST *keys = NULL, *t;
+  int n = 0;
+#if HAVE_QDBM
+  char *k;
+  int ksize;
+
+  if (vlcurfirst(h->db))
+  {
+    do
+    {
+      if (!(k = vlcurkey(h->db, &ksize)))
+        break;
+      t = mutt_new_list();
+      t->data = mutt_substrdup(k, k + ksize);
+      t->next = keys;
+      keys = t;
+      free(k);
+    }
+    while (++n != max && vlcurnext(h->db));
+  }
+#elif HAVE_TC
+  BDBCUR *cur;
+  void *k;
+  int ksize;
+
+  cur = tcbdbcurnew(h->db);
+  if (tcbdbcurfirst(cur))
+  {
+    do
+    {
+      if (!(k = tcbdbcurkey(cur, &ksize)))
+        break;
+      t = mutt_new_list();
+      t->data = mutt_substrdup(k, (char *) k + ksize);
+      t->next = keys;
+      keys = t;
+      tcfree(k);
+    }
+    while (++n != max && tcbdbcurnext(cur));
+  }
+  tcbdbcurdel(cur);
+#elif HAVE_KC
+  KCCUR *cur;
+  char *k;
+  size_t ksize;
+
+  cur = kcdbcursor(h->db);
+  kccurjump(cur);
+  while ((!max || n++ < max) && (k = kccurgetkey(cur, &ksize, 1)))
+  {
+    t = mutt_new_list();
+    t->data = mutt_substrdup(k, k + ksize);
+    t->next = keys;
+    keys = t;
+    kcfree(k);
+  }
+  kccurdel(cur);
+#elif HAVE_GDBM
+  datum key, next;
+
+  key = gdbm_firstkey(h->db);
+  while (key.dptr)
+  {
+    t = mutt_new_list();
+    t->data = mutt_substrdup(key.dptr, key.dptr + key.dsize);
+    t->next = keys;
+    keys = t;
+    if (++n == max)
+    {
+      free(key.dptr);
+      break;
+    }
+    next = gdbm_nextkey(h->db, key);
+    free(key.dptr);
+    key = next;
+  }
+#elif HAVE_DB4
+  DBC *cur;
+  DBT key, data;
+
+  if (h->db->cursor(h->db, NULL, &cur, 0))
+    return NULL;
+  mutt_hcache_dbt_empty_init(&key);
+  mutt_hcache_dbt_empty_init(&data);
+  while ((!max || n++ < max) &&
+         cur->c_get(cur, &key, &data, DB_NEXT) == 0)
+  {
+    t = mutt_new_list();
+    t->data = mutt_substrdup(key.data, (char *) key.data + key.size);
+    t->next = keys;
+    keys = t;
+  }
+  cur->c_close(cur);
+#elif HAVE_LMDB
+  MDB_cursor *cur;
+  MDB_val key, data;
+  int rc;
+
+  if (mdb_get_r_txn(h) != MDB_SUCCESS ||
+      mdb_cursor_open(h->txn, h->db, &cur) != MDB_SUCCESS)
+    return NULL;
+  rc = mdb_cursor_get(cur, &key, &data, MDB_FIRST);
+  while (rc == MDB_SUCCESS && (!max || n++ < max))
+  {
+    t = mutt_new_list();
+    t->data = mutt_substrdup(key.mv_data, (char *) key.mv_data + key.mv_size);
+    t->next = keys;
+    keys = t;
+    rc = mdb_cursor_get(cur, &key, &data, MDB_NEXT);
+  }
+  mdb_cursor_close(cur);
+#endif
+
+  return keys;
+}
+
+/* Gives the space of deleted records back to the file system.  LMDB and
+ * kyotocabinet reuse free pages on their own, and bdb's compaction isn't
+ * available in all the versions we support. */
+static void hcache_compact(header_cache_t *h)
+{
+#if HAVE_QDBM
+  if (!vloptimize(h->db))
+    muttdbg(2, "vloptimize failed for %s", h->path);
+#elif HAVE_TC
+  if (!tcbdboptimize(h->db, 0, 0, 0, -1, -1, UINT8_MAX))
+    muttdbg(2, "tcbdboptimize failed for %s", h->path);
+#elif HAVE_GDBM
+  if (gdbm_reorganize(h->db))
+    muttdbg(2, "gdbm_reorganize failed for %s", h->path);
+#endif
+}
+
+static off_t hcache_file_size(const char *path)
+{
+  struct stat sb;
+
+  if (!path || stat(path, &sb) < 0)
+    return 0;
+  return sb.st_size;
+}
+
+/* A database file holds records for a single folder unless
+ * $header_cache is a plain file. */
+static int hcache_is_shared(void)
+{
+  struct stat sb;
+
+  if (!HeaderCache || !*HeaderCache)
+    return 1;
+  if (stat(HeaderCache, &sb) == 0)
+    return !S_ISDIR(sb.st_mode);
+  return HeaderCache[mutt_strlen(HeaderCache) - 1] != '/';
+}
+
+/* Drops every record for which keep() returns 0, then compacts the
+ * database.  keep() is passed the key as given to mutt_hcache_store(),
+ * without a leading '/', and the stored record.  Returns -1 if the
+ * database is shared with other folders, since their keys can't be told
+ * apart reliably. */
+int mutt_hcache_purge(header_cache_t *h, hcache_keep_t keep, void *arg,
+                      HCACHE_GC *gc)
+{
+  LIST *keys, *k;
+  const char *name;
+  void *data;
+  size_t flen = 0;
+
+  if (!h)
+  {
+    gc->skipped = _("its header cache could not be opened");
+    return -1;
+  }
+  if (hcache_is_shared())
+  {
+    gc->skipped = _("$header_cache is a single file shared by all folders");
+    return -1;
+  }
+
+  gc->size = hcache_file_size(h->path);
+
+#if !HAVE_DB4
+  flen = mutt_strlen(h->folder);
+#endif
+
+  keys = hcache_keys(h, 0);
+  mutt_hcache_begin(h);
+  for (k = keys; k; k = k->next)
+  {
+    if (mutt_strncmp(k->data, h->folder, flen))
+      continue;
+    gc->records++;
+
+    name = k->data + flen;
+    data = mutt_hcache_fetch_raw(h, name, strlen);
+    if (!keep(*name == '/' ? name + 1 : name, data, arg))
+    {
+      mutt_hcache_delete(h, name, strlen);
+      gc->dropped++;
+    }
+    mutt_hcache_free(&data);
+  }
+  mutt_hcache_commit(h);
+  mutt_free_list(&keys);
+
+  if (gc->dropped)
+    hcache_compact(h);
+  gc->compacted = hcache_file_size(h->path);
+
+  return 0;
+}
+
+/* A keep() callback for mutt_hcache_purge(): arg is a HASH of the
+ * folder's keys. */
+int mutt_hcache_keep_listed(const char *key, void *data, void *arg)
+{
+  return hash_find((HASH *) arg, key) != NULL;
+}
+
+/* Removes the databases of local folders that no longer exist from a
+ * $header_cache directory.  These are named after the md5 of the folder
+ * path, so the folder is recovered from the first key: Maildir keys are
+ * the folder path followed by "/" and the message file name.  Databases
+ * whose folder can't be determined are left alone, and so are those
+ * whose folder's parent directory is missing too, since that is what an
+ * unmounted file system looks like.  The removed databases are added to
+ * gc->removed.  Also records the lookup counters of this session in gc. */
+void mutt_hcache_sweep(HCACHE_GC *gc)
+{
+#if !HAVE_DB4
+  DIR *dp;
+  struct dirent *de;
+  struct stat sb;
+  header_cache_t *h;
+  LIST *keys;
+  BUFFER *file, *folder;
+  char *p;
+  int orphan;
+#endif
+
+  gc->fetches = HcacheFetches;
+  gc->hits = HcacheHits;
+
+#if !HAVE_DB4
+  if (hcache_is_shared() || !(dp = opendir(HeaderCache)))
+    return;
+
+  file = mutt_buffer_pool_get();
+  folder = mutt_buffer_pool_get();
+  while ((de = readdir(dp)) != NULL)
+  {
+    if (strspn(de->d_name, "0123456789abcdef") != 32 ||
+        (de->d_name[32] && de->d_name[32] != '-') ||
+        strstr(de->d_name, "-lock"))
+      continue;
+
+    mutt_buffer_concat_path(file, HeaderCache, de->d_name);
+    if (lstat(mutt_b2s(file), &sb) < 0 || !S_ISREG(sb.st_mode))
+      continue;
+
+    h = safe_calloc(1, sizeof(struct header_cache));
+    h->folder = safe_strdup("");
+    if (hcache_open(h, mutt_b2s(file)))
+    {
+      FREE(&h->folder);
+      FREE(&h);
+      continue;
+    }
+
+    orphan = 0;
+    keys = hcache_keys(h, 1);
+    if (keys && keys->data[0] == '/' && (p = strrchr(keys->data, '/')) &&
+        p != keys->data)
+    {
+      *p = '\0';
+      mutt_buffer_strcpy(folder, keys->data);
+      orphan = (stat(keys->data, &sb) < 0 && errno == ENOENT);
+      if (orphan && (p = strrchr(keys->data, '/')) && p != keys->data)
+      {
+        *p = '\0';
+        orphan = (stat(keys->data, &sb) == 0);
+      }
+    }
+    mutt_free_list(&keys);
+    mutt_hcache_close(h);
+
+    if (orphan)
+    {
+      muttdbg(1, "removing header cache %s of a deleted folder",
+              mutt_b2s(file));
+      safe_asprintf(&p, "%s (%s)", de->d_name, mutt_b2s(folder));
+      gc->removed = mutt_add_list(gc->removed, p);
+      FREE(&p);
+      gc->orphans++;
+      gc->orphan_size += hcache_file_size(mutt_b2s(file));
+      unlink(mutt_b2s(file));
+#if HAVE_LMDB
+      mutt_buffer_addstr(file, "-lock");
+      unlink(mutt_b2s(file));
+#endif
+    }
+  }
+  closedir(dp);
+  mutt_buffer_pool_release(&file);
+  mutt_buffer_pool_release(&folder);
+#endif
+}
+
 #if HAVE_DB4
 const char *mutt_hcache_backend(void)
 {
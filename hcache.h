@@ -46,6 +46,32 @@ int mutt_hcache_store_raw(header_cache_t *h, const char *filename, void *data,
                           size_t dlen, size_t (*keylen) (const char *fn));
 int mutt_hcache_delete(header_cache_t *h, const char *filename, size_t (*keylen)(const char *fn));
 
+/* Bulk callers bracket their stores with these, see hcache.c */
+int mutt_hcache_begin(header_cache_t *h);
+int mutt_hcache_commit(header_cache_t *h);
+
+/* Results of the header-cache-gc command */
+typedef struct hcache_gc
+{
+  unsigned int records;         /* records of the folder examined */
+  unsigned int dropped;         /* stale records deleted */
+  off_t size;                   /* database size before the purge */
+  off_t compacted;              /* and after it */
+  unsigned int orphans;         /* databases of deleted folders removed */
+  off_t orphan_size;
+  LIST *removed;                /* "database (folder)" of each of them */
+  const char *skipped;          /* why the folder wasn't purged */
+  unsigned int fetches;         /* header lookups this session */
+  unsigned int hits;
+} HCACHE_GC;
+
+typedef int (*hcache_keep_t)(const char *key, void *data, void *arg);
+
+int mutt_hcache_purge(header_cache_t *h, hcache_keep_t keep, void *arg,
+                      HCACHE_GC *gc);
+int mutt_hcache_keep_listed(const char *key, void *data, void *arg);
+void mutt_hcache_sweep(HCACHE_GC *gc);
+
 const char *mutt_hcache_backend(void);
 
 #endif /* _HCACHE_H_ */
@@ -92,7 +92,7 @@ sub process_struct($$) {
 
 my $md5;
 my $line;
-my $BASEVERSION = "2";
+my $BASEVERSION = "4";
 
 $md5 = Digest::MD5->new;
 
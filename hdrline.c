@@ -36,19 +36,63 @@
 #include <alloca.h>
 #endif
 
+/* The same list addresses occur in many messages of a folder, so the
+ * results of mutt_is_mail_list() and mutt_is_subscribed_list() are kept
+ * per address until a list command changes any RX_LIST.
+ */
+#define LIST_CACHE_MAX   4096
+
+#define LIST_KNOWN       (1<<0)
+#define LIST_MAIL        (1<<1)
+#define LIST_SUBSCRIBED  (1<<2)
+
+static HASH *ListCache = NULL;
+static unsigned int ListCacheGen = 0;
+static int ListCacheCount = 0;
+
+static int list_flags(const char *mailbox)
+{
+  intptr_t flags;
+
+  if (!mailbox)
+    return 0;
+
+  if (!ListCache || ListCacheGen != RxListGeneration ||
+      ListCacheCount >= LIST_CACHE_MAX)
+  {
+    hash_destroy(&ListCache, NULL);
+    ListCache = hash_create(LIST_CACHE_MAX, MUTT_HASH_STRDUP_KEYS);
+    ListCacheGen = RxListGeneration;
+    ListCacheCount = 0;
+  }
+
+  if ((flags = (intptr_t) hash_find(ListCache, mailbox)))
+    return flags;
+
+  flags = LIST_KNOWN;
+  if (!mutt_match_rx_list(mailbox, UnMailLists))
+  {
+    if (mutt_match_rx_list(mailbox, MailLists))
+      flags |= LIST_MAIL;
+    if (!mutt_match_rx_list(mailbox, UnSubscribedLists) &&
+        mutt_match_rx_list(mailbox, SubscribedLists))
+      flags |= LIST_SUBSCRIBED;
+  }
+
+  hash_insert(ListCache, mailbox, (void *) flags);
+  ListCacheCount++;
+
+  return flags;
+}
+
 int mutt_is_mail_list(ADDRESS *addr)
 {
-  if (!mutt_match_rx_list(addr->mailbox, UnMailLists))
-    return mutt_match_rx_list(addr->mailbox, MailLists);
-  return 0;
+  return (list_flags(addr->mailbox) & LIST_MAIL) ? 1 : 0;
 }
 
 int mutt_is_subscribed_list(ADDRESS *addr)
 {
-  if (!mutt_match_rx_list(addr->mailbox, UnMailLists)
-      && !mutt_match_rx_list(addr->mailbox, UnSubscribedLists))
-    return mutt_match_rx_list(addr->mailbox, SubscribedLists);
-  return 0;
+  return (list_flags(addr->mailbox) & LIST_SUBSCRIBED) ? 1 : 0;
 }
 
 /* Search for a mailing list in the list of addresses pointed to by adr.
@@ -303,6 +303,7 @@ static int label_message(CONTEXT *ctx, HEADER *hdr, char *new)
 
   hdr->changed = 1;
   hdr->env->changed |= MUTT_ENV_CHANGED_XLABEL;
+  mutt_invalidate_index_lines();
   return 1;
 }
 
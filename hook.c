@@ -60,6 +60,9 @@ int mutt_parse_hook(BUFFER *buf, BUFFER *s, union pointer_long_t udata, BUFFER *
   command = mutt_buffer_pool_get();
   pattern = mutt_buffer_pool_get();
 
+  if (data & (MUTT_CHARSETHOOK | MUTT_ICONVHOOK))
+    mutt_iconv_cache_flush();
+
   if (*s->dptr == '!')
   {
     s->dptr++;
@@ -281,6 +284,9 @@ static void delete_hooks(int type)
   HOOK *h;
   HOOK *prev;
 
+  if (type == 0 || (type & (MUTT_CHARSETHOOK | MUTT_ICONVHOOK)))
+    mutt_iconv_cache_flush();
+
   while (h = Hooks, h && (type == 0 || type == h->type))
   {
     Hooks = h->next;
@@ -206,48 +206,66 @@ void imap_logout_all(void)
   }
 }
 
-/* imap_read_literal: read bytes bytes from server into file. Not explicitly
- *   buffered, relies on FILE buffering. */
+/* imap_read_literal: read bytes bytes from server into file. The data
+ *   is read in blocks with mutt_socket_read() and \r\n is converted to
+ *   \n a span at a time. */
 int imap_read_literal(FILE *fp, IMAP_DATA *idata, unsigned int bytes, progress_t *pbar)
 {
-  unsigned int pos;
-  char c;
+  char buf[HUGE_STRING];
+  char *s, *end, *cr;
+  unsigned int pos = 0;
+  int n;
 
   int r = 0;
 
   muttdbg(2, "imap_read_literal: reading %ld bytes", bytes);
 
-  for (pos = 0; pos < bytes; pos++)
+  if (pbar)
+    mutt_progress_update(pbar, 0, -1);
+
+  while (pos < bytes)
   {
-    if (mutt_socket_readchar(idata->conn, &c) != 1)
+    n = mutt_socket_read(idata->conn, buf, MIN(sizeof(buf), bytes - pos));
+    if (n <= 0)
     {
       muttdbg(1, "imap_read_literal: error during read, %ld bytes read", pos);
       idata->status = IMAP_FATAL;
 
       return -1;
     }
+    pos += n;
 
     /* Strip \r from \r\n, apparantly even literals use \r\n-terminated
-       strings ?! */
-    if (r == 1 && c != '\n')
-      fputc('\r', fp);
-
-    if (c == '\r')
+       strings ?!  A \r ending one block is held until the next. */
+    s = buf;
+    end = buf + n;
+    if (r)
     {
-      r = 1;
-      continue;
-    }
-    else
+      if (*s != '\n')
+        fputc('\r', fp);
       r = 0;
+    }
+    while (s < end)
+    {
+      if (!(cr = memchr(s, '\r', end - s)))
+        cr = end;
+      fwrite(s, 1, cr - s, fp);
+#ifdef DEBUG
+      if (debuglevel >= IMAP_LOG_LTRL)
+        fwrite(s, 1, cr - s, debugfile);
+#endif
+      if (cr == end)
+        break;
 
-    fputc(c, fp);
+      if (cr + 1 == end)
+        r = 1;
+      else if (cr[1] != '\n')
+        fputc('\r', fp);
+      s = cr + 1;
+    }
 
-    if (pbar && !(pos % 1024))
+    if (pbar)
       mutt_progress_update(pbar, pos, -1);
-#ifdef DEBUG
-    if (debuglevel >= IMAP_LOG_LTRL)
-      fputc(c, debugfile);
-#endif
   }
 
   return 0;
@@ -1523,6 +1541,7 @@ int imap_sync_mailbox(CONTEXT *ctx, int expunge, int *index_hint)
 
 #if USE_HCACHE
   idata->hcache = imap_hcache_open(idata, NULL);
+  mutt_hcache_begin(idata->hcache);
 #endif
 
   /* save messages with real (non-flag) changes */
@@ -1587,12 +1606,18 @@ int imap_sync_mailbox(CONTEXT *ctx, int expunge, int *index_hint)
           h->env->changed = 0;
 #if USE_HCACHE
         idata->hcache = imap_hcache_open(idata, NULL);
+        mutt_hcache_begin(idata->hcache);
 #endif
       }
     }
+#if USE_HCACHE
+    else if (h->active && h->mime_skel_dirty)
+      imap_hcache_put(idata, h);
+#endif
   }
 
 #if USE_HCACHE
+  mutt_hcache_commit(idata->hcache);
   imap_hcache_close(idata);
 #endif
 
@@ -1895,6 +1920,79 @@ static int imap_save_to_header_cache(CONTEXT *ctx, HEADER *h)
   return rc;
 }
 
+/* Only opens the cache if it isn't open already, so that
+ * imap_commit_header_cache() never closes one it didn't open.  Saves go
+ * through an already open cache anyway. */
+static int imap_begin_header_cache(CONTEXT *ctx)
+{
+#ifdef USE_HCACHE
+  IMAP_DATA *idata = (IMAP_DATA *)ctx->data;
+
+  if (idata->hcache || !(idata->hcache = imap_hcache_open(idata, NULL)))
+    return -1;
+  return mutt_hcache_begin(idata->hcache);
+#else
+  return -1;
+#endif
+}
+
+static int imap_commit_header_cache(CONTEXT *ctx)
+{
+  int rc = -1;
+#ifdef USE_HCACHE
+  IMAP_DATA *idata = (IMAP_DATA *)ctx->data;
+
+  rc = mutt_hcache_commit(idata->hcache);
+  imap_hcache_close(idata);
+#endif
+  return rc;
+}
+
+#ifdef USE_HCACHE
+/* Keeps the folder state records and the headers of messages that are
+ * still in the mailbox under the current UIDVALIDITY. */
+static int imap_hcache_keep(const char *key, void *data, void *arg)
+{
+  IMAP_DATA *idata = (IMAP_DATA *)arg;
+  unsigned int uid, uv;
+
+  if (!mutt_strcmp(key, "UIDVALIDITY") || !mutt_strcmp(key, "UIDNEXT") ||
+      !mutt_strcmp(key, "MODSEQ") || !mutt_strcmp(key, "UIDSEQSET"))
+    return 1;
+
+  if (!data || mutt_atoui(key, &uid, 0) < 0)
+    return 0;
+
+  memcpy(&uv, data, sizeof(unsigned int));
+  return uv == idata->uid_validity && int_hash_find(idata->uid_hash, uid);
+}
+#endif
+
+static int imap_purge_header_cache(CONTEXT *ctx, struct hcache_gc *gc)
+{
+  int rc = -1;
+#ifdef USE_HCACHE
+  int close_hc = 1;
+  IMAP_DATA *idata;
+
+  idata = (IMAP_DATA *)ctx->data;
+  if (idata->state != IMAP_SELECTED || !idata->uid_hash)
+  {
+    gc->skipped = _("the folder is not selected on the server");
+    return -1;
+  }
+
+  if (idata->hcache)
+    close_hc = 0;
+  else
+    idata->hcache = imap_hcache_open(idata, NULL);
+  rc = mutt_hcache_purge(idata->hcache, imap_hcache_keep, idata, gc);
+  if (close_hc)
+    imap_hcache_close(idata);
+#endif
+  return rc;
+}
+
 /* split path into (idata,mailbox name) */
 static int imap_get_mailbox(const char *path, IMAP_DATA **hidata, char *buf, size_t blen)
 {
@@ -2655,4 +2753,7 @@ struct mx_ops mx_imap_ops = {
   .check = imap_check_mailbox_reopen,
   .sync = NULL,      /* imap syncing is handled by imap_sync_mailbox */
   .save_to_header_cache = imap_save_to_header_cache,
+  .begin_header_cache = imap_begin_header_cache,
+  .commit_header_cache = imap_commit_header_cache,
+  .purge_header_cache = imap_purge_header_cache,
 };
@@ -268,6 +268,7 @@ retry:
 
 #if USE_HCACHE
   idata->hcache = imap_hcache_open(idata, NULL);
+  mutt_hcache_begin(idata->hcache);
 
   if (idata->hcache && initial_download)
   {
@@ -423,6 +424,7 @@ retry:
 
 bail:
 #if USE_HCACHE
+  mutt_hcache_commit(idata->hcache);
   imap_hcache_close(idata);
   FREE(&uid_seqset);
 #endif /* USE_HCACHE */
@@ -738,6 +740,7 @@ static int read_headers_condstore_qresync_updates(IMAP_DATA *idata,
     Sort = old_sort;
 
     idata->hcache = imap_hcache_open(idata, NULL);
+    mutt_hcache_begin(idata->hcache);
     idata->reopen &= ~IMAP_EXPUNGE_PENDING;
   }
 
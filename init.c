@@ -43,6 +43,10 @@
 #include "init.h"
 #include "mailbox.h"
 
+#ifdef USE_HCACHE
+#include "hcache.h"
+#endif
+
 #include <ctype.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -501,6 +505,8 @@ int mutt_add_to_rx_list(RX_LIST **list, const char *s, int flags, BUFFER *err)
   {
     t = mutt_new_rx_list();
     t->rx = rx;
+    t->flags = flags;
+    RxListGeneration++;
     if (last)
       last->next = t;
     else
@@ -564,6 +570,7 @@ static int add_to_replace_list(REPLACE_LIST **list, const char *pat, const char
 
   /* Now t is the REPLACE_LIST* that we want to modify. It is prepared. */
   t->template = safe_strdup(templ);
+  RxListGeneration++;
 
   /* Find highest match number in template string */
   t->nmatch = 0;
@@ -608,7 +615,9 @@ static int remove_from_replace_list(REPLACE_LIST **list, const char *pat)
     *list = cur->next;
     mutt_free_regexp(&cur->rx);
     FREE(&cur->template);
+    mutt_free_rx_prefilter(&cur->prefilter);
     FREE(&cur);
+    RxListGeneration++;
     return 1;
   }
 
@@ -620,9 +629,11 @@ static int remove_from_replace_list(REPLACE_LIST **list, const char *pat)
       prev->next = cur->next;
       mutt_free_regexp(&cur->rx);
       FREE(&cur->template);
+      mutt_free_rx_prefilter(&cur->prefilter);
       FREE(&cur);
       cur = prev->next;
       ++nremoved;
+      RxListGeneration++;
     }
     else
       cur = cur->next;
@@ -3007,6 +3018,11 @@ int mutt_parse_rc_line(const char *line, BUFFER *err)
   if (!line || !*line)
     return 0;
 
+  /* any command may change what $index_format expands to, or the
+   * lists and alternates cached pattern results depend on */
+  mutt_invalidate_index_lines();
+  PatternCacheGeneration++;
+
   line_buffer = mutt_buffer_pool_get();
   token = mutt_buffer_pool_get();
 
@@ -3044,6 +3060,69 @@ static int parse_cd(BUFFER *tmp, BUFFER *s, union pointer_long_t udata, BUFFER *
   return (0);
 }
 
+#ifdef USE_HCACHE
+/* Drops stale records from the header cache of the open folder, compacts
+ * it, and removes the caches of deleted local folders. */
+static int parse_header_cache_gc(BUFFER *buf, BUFFER *s, union pointer_long_t udata, BUFFER *err)
+{
+  HCACHE_GC gc;
+  char size[SHORT_STRING], compacted[SHORT_STRING], orphans[SHORT_STRING];
+  BUFFER *msg;
+  LIST *l;
+
+  if (!HeaderCache)
+  {
+    mutt_buffer_strcpy(err, _("$header_cache is not set"));
+    return -1;
+  }
+
+  memset(&gc, 0, sizeof(gc));
+  if (Context && mx_purge_header_cache(Context, &gc) < 0 && !gc.skipped)
+    gc.skipped = _("its header cache could not be read");
+  mutt_hcache_sweep(&gc);
+
+  msg = mutt_buffer_pool_get();
+  mutt_pretty_size(orphans, sizeof(orphans), gc.orphan_size);
+  if (gc.records)
+  {
+    mutt_pretty_size(size, sizeof(size), gc.size);
+    mutt_pretty_size(compacted, sizeof(compacted), gc.compacted);
+    mutt_buffer_printf(msg, _("Header cache: %u/%u records dropped (%s -> %s), "
+                              "deleted folders: %u (%s), hits: %u/%u"),
+                       gc.dropped, gc.records, size, compacted,
+                       gc.orphans, orphans, gc.hits, gc.fetches);
+  }
+  else
+    mutt_buffer_printf(msg, _("Header cache: deleted folders: %u (%s), hits: %u/%u"),
+                       gc.orphans, orphans, gc.hits, gc.fetches);
+
+  if (gc.skipped)
+  {
+    mutt_buffer_addstr(msg, "; ");
+    /* L10N: header-cache-gc couldn't purge the open folder's cache.
+       %s is the reason, e.g. "this folder type has no header cache". */
+    mutt_buffer_add_printf(msg, _("current folder not purged: %s"), gc.skipped);
+  }
+
+  if (gc.removed)
+  {
+    mutt_buffer_addstr(msg, "; ");
+    mutt_buffer_addstr(msg, _("removed:"));
+    for (l = gc.removed; l; l = l->next)
+    {
+      mutt_buffer_addch(msg, ' ');
+      mutt_buffer_addstr(msg, l->data);
+    }
+    mutt_free_list(&gc.removed);
+  }
+
+  mutt_message("%s", mutt_b2s(msg));
+  mutt_buffer_pool_release(&msg);
+
+  return 0;
+}
+#endif
+
 
 /* line         command to execute
 
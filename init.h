@@ -1476,6 +1476,21 @@ struct option_t MuttVars[] = {
   ** or less optimal for most use cases.
   */
 # endif /* HAVE_GDBM || HAVE_DB4 */
+  { "header_cache_sync", DT_BOOL, R_NONE, {.l=OPTHCACHESYNC}, {.l=0} },
+  /*
+  ** .pp
+  ** When \fIset\fP, Mutt forces header cache updates to disk at the end
+  ** of every batch of stores, for example every thousand headers while
+  ** the headers of a large folder are downloaded.
+  ** .pp
+  ** When \fIunset\fP, LMDB still writes each batch to disk but defers
+  ** the final step of a commit to the next batch or to closing the
+  ** cache.  A system crash may then undo the last batch, which is simply
+  ** fetched again, but leaves the database intact.  The other backends
+  ** leave writing the data out to the operating system.  After a system
+  ** crash their cache file may be damaged and should then be removed,
+  ** so set this option if that is a concern.
+  */
 #endif /* USE_HCACHE */
   { "header_color_partial", DT_BOOL, R_PAGER_FLOW, {.l=OPTHEADERCOLORPARTIAL}, {.l=0} },
   /*
@@ -2025,6 +2040,14 @@ struct option_t MuttVars[] = {
   ** .pp
   ** This variable configures how often (in seconds) mutt should look for
   ** new mail. Also see the $$timeout variable.
+  ** .pp
+  ** Local mailboxes that are slow to check, for example on a busy NFS
+  ** server, are checked less often: each check taking a quarter of a
+  ** second or more doubles the interval for that mailbox, up to 16 times
+  ** $$mail_check.  One fast check restores the normal interval.  Time
+  ** spent counting messages for $$mail_check_stats is not taken into
+  ** account.  Forced checks, such as the one done by \fC<check-stats>\fP,
+  ** always poll every mailbox.
   */
   { "mail_check_recent",DT_BOOL, R_NONE, {.l=OPTMAILCHECKRECENT}, {.l=1} },
   /*
@@ -2379,17 +2402,16 @@ struct option_t MuttVars[] = {
   ** This variable, when \fIset\fP, makes the thread tree narrower, allowing
   ** deeper threads to fit on the screen.
   */
-#ifdef USE_SOCKET
   { "net_inc",  DT_NUM,  R_NONE, {.p=&NetInc}, {.l=10} },
   /*
   ** .pp
   ** Operations that expect to transfer a large amount of data over the
   ** network will update their progress every $$net_inc kilobytes.
-  ** If set to 0, no progress messages will be displayed.
+  ** Decoding a large message for display in the pager also uses this
+  ** step.  If set to 0, no progress messages will be displayed.
   ** .pp
   ** See also $$read_inc, $$write_inc and $$net_inc.
   */
-#endif
   { "new_mail_command", DT_CMD_PATH, R_NONE, {.p=&NewMailCmd}, {.p=0} },
   /*
   ** .pp
@@ -5020,6 +5042,9 @@ static int parse_unignore(BUFFER *, BUFFER *, union pointer_long_t, BUFFER *);
 static int parse_run(BUFFER *, BUFFER *, union pointer_long_t, BUFFER *);
 static int parse_source(BUFFER *, BUFFER *, union pointer_long_t, BUFFER *);
 static int parse_cd(BUFFER *, BUFFER *, union pointer_long_t, BUFFER *);
+#ifdef USE_HCACHE
+static int parse_header_cache_gc(BUFFER *, BUFFER *, union pointer_long_t, BUFFER *);
+#endif
 static int parse_set(BUFFER *, BUFFER *, union pointer_long_t, BUFFER *);
 static int parse_setenv(BUFFER *, BUFFER *, union pointer_long_t, BUFFER *);
 static int parse_my_hdr(BUFFER *, BUFFER *, union pointer_long_t, BUFFER *);
@@ -5083,6 +5108,9 @@ const struct command_t Commands[] = {
   { "ungroup",          parse_group,            {.l=MUTT_UNGROUP} },
   { "hdr_order",        parse_list,             {.p=&HeaderOrderList} },
   { "unhdr_order",      parse_unlist,           {.p=&HeaderOrderList} },
+#ifdef USE_HCACHE
+  { "header-cache-gc",  parse_header_cache_gc,  {.l=0} },
+#endif
 #ifdef HAVE_ICONV
   { "iconv-hook",       mutt_parse_hook,        {.l=MUTT_ICONVHOOK} },
 #endif
@@ -84,6 +84,8 @@ int mx_access(const char*, int);
 int mx_check_empty(const char *);
 int mx_msg_padding_size(CONTEXT *);
 int mx_save_to_header_cache(CONTEXT *, HEADER *);
+void mx_store_mime_skels(CONTEXT *);
+int mx_purge_header_cache(CONTEXT *, struct hcache_gc *);
 
 int mx_is_maildir(const char *);
 int mx_is_mh(const char *);
@@ -1423,6 +1423,9 @@ cleanup_and_exit:
   mutt_autocrypt_cleanup();
 #endif
   mutt_browser_cleanup();
+#ifdef USE_SIDEBAR
+  mutt_sb_cleanup();
+#endif
   mutt_commands_cleanup();
   crypt_cleanup();
   mutt_signal_cleanup();
@@ -78,6 +78,23 @@ void mbox_unlock_mailbox(CONTEXT *ctx)
   }
 }
 
+/* Advances loc past the line that fgets(buf, len, fp) just read.
+ *
+ * Calling ftello() for every line dominates the time needed to scan a
+ * large folder, so the position is only asked for when the line length
+ * can't be trusted: a line containing a NUL byte, or the last line of
+ * the file without a newline.
+ */
+static void mbox_advance_loc(FILE *fp, const char *buf, size_t len, LOFF_T *loc)
+{
+  size_t l = strlen(buf);
+
+  if (l && (buf[l - 1] == '\n' || l == len - 1))
+    *loc += l;
+  else
+    *loc = ftello(fp);
+}
+
 int mmdf_parse_mailbox(CONTEXT *ctx)
 {
   char buf[HUGE_STRING];
@@ -200,13 +217,14 @@ int mmdf_parse_mailbox(CONTEXT *ctx)
       if (hdr->content->length < 0)
       {
         lines = -1;
-        do
+        loc = ftello(ctx->fp);
+        while (fgets(buf, sizeof(buf) - 1, ctx->fp) != NULL)
         {
-          loc = ftello(ctx->fp);
-          if (fgets(buf, sizeof(buf) - 1, ctx->fp) == NULL)
-            break;
           lines++;
-        } while (mutt_strcmp(buf, MMDF_SEP) != 0);
+          if (mutt_strcmp(buf, MMDF_SEP) == 0)
+            break;
+          mbox_advance_loc(ctx->fp, buf, sizeof(buf) - 1, &loc);
+        }
 
         hdr->lines = lines;
         hdr->content->length = loc - hdr->content->offset;
@@ -403,13 +421,17 @@ int mbox_parse_mailbox(CONTEXT *ctx)
           if (curhdr->lines == 0)
           {
             LOFF_T cl = curhdr->content->length;
+            size_t n;
+            char *p;
 
             /* count the number of lines in this message */
             if (fseeko(ctx->fp, loc, SEEK_SET) != 0)
               muttdbg(1, "mbox_parse_mailbox: fseek() failed");
-            while (cl-- > 0)
+            while (cl > 0 &&
+                   (n = fread(buf, 1, MIN(cl, (LOFF_T) sizeof(buf)), ctx->fp)) > 0)
             {
-              if (fgetc(ctx->fp) == '\n')
+              cl -= n;
+              for (p = buf; (p = memchr(p, '\n', buf + n - p)) != NULL; p++)
                 curhdr->lines++;
             }
           }
@@ -432,6 +454,7 @@ int mbox_parse_mailbox(CONTEXT *ctx)
 
       lines = 0;
       has_mbox_sep = 0;
+      loc = ftello(ctx->fp);
     }
     else
     {
@@ -443,9 +466,8 @@ int mbox_parse_mailbox(CONTEXT *ctx)
         mutt_error _("Mailbox is corrupt!");
         return (-1);
       }
+      mbox_advance_loc(ctx->fp, buf, sizeof(buf), &loc);
     }
-
-    loc = ftello(ctx->fp);
   }
 
   /*
@@ -480,6 +502,71 @@ int mbox_parse_mailbox(CONTEXT *ctx)
 
 #undef PREV
 
+/* Parses the messages appended to an mbox or MMDF folder since it was
+ * *offset bytes long, so the mailbox statistics don't need the whole
+ * folder to be read again.  The counts of the new messages are added to
+ * msgcount, unread and flagged, and *offset and *mtime are updated to the
+ * size and mtime of the folder.
+ *
+ * Returns 0 on success, or -1 if there is no message separator at *offset,
+ * i.e. the folder was rewritten and has to be read completely.
+ */
+int mbox_parse_appended(const char *path, LOFF_T *offset, struct timespec *mtime,
+                        int *msgcount, int *unread, int *flagged)
+{
+  CONTEXT ctx;
+  char buf[LONG_STRING];
+  int rc = -1;
+
+  memset(&ctx, 0, sizeof(ctx));
+  ctx.path = safe_strdup(path);
+  ctx.magic = mx_get_magic(path);
+  ctx.msgnotreadyet = -1;
+  ctx.quiet = 1;
+  ctx.readonly = 1;
+  ctx.peekonly = 1;
+
+  if ((ctx.magic != MUTT_MBOX && ctx.magic != MUTT_MMDF) ||
+      (ctx.fp = fopen(ctx.path, "r")) == NULL)
+    goto cleanup;
+
+  mutt_block_signals();
+  if (mbox_lock_mailbox(&ctx, 0, 1) == -1)
+  {
+    mutt_unblock_signals();
+    goto cleanup;
+  }
+
+  /* the same check mbox_check_mailbox() uses for new mail */
+  if (fseeko(ctx.fp, *offset, SEEK_SET) == 0 &&
+      fgets(buf, sizeof(buf), ctx.fp) != NULL &&
+      ((ctx.magic == MUTT_MBOX && mutt_strncmp("From ", buf, 5) == 0) ||
+       (ctx.magic == MUTT_MMDF && mutt_strcmp(MMDF_SEP, buf) == 0)) &&
+      fseeko(ctx.fp, *offset, SEEK_SET) == 0)
+  {
+    if (ctx.magic == MUTT_MBOX)
+      rc = mbox_parse_mailbox(&ctx);
+    else
+      rc = mmdf_parse_mailbox(&ctx);
+  }
+
+  mbox_unlock_mailbox(&ctx);
+  mutt_unblock_signals();
+
+  if (rc == 0)
+  {
+    *msgcount += ctx.msgcount;
+    *unread   += ctx.unread;
+    *flagged  += ctx.flagged;
+    *offset = ctx.size;
+    *mtime  = ctx.mtime;
+  }
+
+cleanup:
+  mx_fastclose_mailbox(&ctx);
+  return rc;
+}
+
 /* open a mbox or mmdf style mailbox */
 static int mbox_open_mailbox(CONTEXT *ctx)
 {
@@ -1454,6 +1541,7 @@ struct mx_ops mx_mbox_ops = {
   .sync = mbox_sync_mailbox,
   .msg_padding_size = mbox_msg_padding_size,
   .save_to_header_cache = NULL,
+  .purge_header_cache = NULL,
 };
 
 struct mx_ops mx_mmdf_ops = {
@@ -1468,4 +1556,5 @@ struct mx_ops mx_mmdf_ops = {
   .sync = mbox_sync_mailbox,
   .msg_padding_size = mmdf_msg_padding_size,
   .save_to_header_cache = NULL,
+  .purge_header_cache = NULL,
 };
@@ -82,6 +82,9 @@ struct mh_data
 {
   struct timespec mtime_cur;
   mode_t mh_umask;
+#if USE_HCACHE
+  header_cache_t *hcache;       /* open between begin/commit_header_cache */
+#endif
 };
 
 /* mh_sequences support */
@@ -1166,6 +1169,7 @@ static void maildir_delayed_parsing(CONTEXT * ctx, struct maildir **md,
 
 #if USE_HCACHE
   hc = mutt_hcache_open(HeaderCache, ctx->path, NULL);
+  mutt_hcache_begin(hc);
 #endif
 
   fn = mutt_buffer_pool_get();
@@ -1232,6 +1236,7 @@ static void maildir_delayed_parsing(CONTEXT * ctx, struct maildir **md,
     last = p;
   }
 #if USE_HCACHE
+  mutt_hcache_commit(hc);
   mutt_hcache_close(hc);
 #endif
 
@@ -1999,7 +2004,10 @@ int mh_sync_mailbox(CONTEXT * ctx, int *index_hint)
 
 #if USE_HCACHE
   if (ctx->magic == MUTT_MAILDIR || ctx->magic == MUTT_MH)
+  {
     hc = mutt_hcache_open(HeaderCache, ctx->path, NULL);
+    mutt_hcache_begin(hc);
+  }
 #endif /* USE_HCACHE */
 
   if (!ctx->quiet)
@@ -2062,7 +2070,7 @@ int mh_sync_mailbox(CONTEXT * ctx, int *index_hint)
     }
 
 #if USE_HCACHE
-    if (ctx->hdrs[i]->changed)
+    if (ctx->hdrs[i]->changed || ctx->hdrs[i]->mime_skel_dirty)
     {
       if (ctx->magic == MUTT_MAILDIR)
         mutt_hcache_store(hc, ctx->hdrs[i]->path + 3, ctx->hdrs[i],
@@ -2079,7 +2087,10 @@ int mh_sync_mailbox(CONTEXT * ctx, int *index_hint)
 
 #if USE_HCACHE
   if (ctx->magic == MUTT_MAILDIR || ctx->magic == MUTT_MH)
+  {
+    mutt_hcache_commit(hc);
     mutt_hcache_close(hc);
+  }
 #endif /* USE_HCACHE */
 
   if (ctx->magic == MUTT_MH)
@@ -2537,10 +2548,12 @@ static int maildir_save_to_header_cache(CONTEXT *ctx, HEADER *h)
 #if USE_HCACHE
   header_cache_t *hc;
 
-  hc = mutt_hcache_open(HeaderCache, ctx->path, NULL);
+  if (!(hc = mh_data(ctx)->hcache))
+    hc = mutt_hcache_open(HeaderCache, ctx->path, NULL);
   rc = mutt_hcache_store(hc, h->path + 3, h, 0, &maildir_hcache_keylen,
                          MUTT_GENERATE_UIDVALIDITY);
-  mutt_hcache_close(hc);
+  if (hc != mh_data(ctx)->hcache)
+    mutt_hcache_close(hc);
 #endif
   return rc;
 }
@@ -2552,9 +2565,75 @@ static int mh_save_to_header_cache(CONTEXT *ctx, HEADER *h)
 #if USE_HCACHE
   header_cache_t *hc;
 
-  hc = mutt_hcache_open(HeaderCache, ctx->path, NULL);
+  if (!(hc = mh_data(ctx)->hcache))
+    hc = mutt_hcache_open(HeaderCache, ctx->path, NULL);
   rc = mutt_hcache_store(hc, h->path, h, 0, strlen, MUTT_GENERATE_UIDVALIDITY);
+  if (hc != mh_data(ctx)->hcache)
+    mutt_hcache_close(hc);
+#endif
+  return rc;
+}
+
+static int mh_begin_header_cache(CONTEXT *ctx)
+{
+#if USE_HCACHE
+  struct mh_data *data = mh_data(ctx);
+
+  if (data->hcache ||
+      !(data->hcache = mutt_hcache_open(HeaderCache, ctx->path, NULL)))
+    return -1;
+  return mutt_hcache_begin(data->hcache);
+#else
+  return -1;
+#endif
+}
+
+static int mh_commit_header_cache(CONTEXT *ctx)
+{
+  int rc = -1;
+#if USE_HCACHE
+  struct mh_data *data = mh_data(ctx);
+
+  rc = mutt_hcache_commit(data->hcache);
+  mutt_hcache_close(data->hcache);
+  data->hcache = NULL;
+#endif
+  return rc;
+}
+
+
+/* Drops the header cache records of messages no longer in the folder. */
+static int mh_purge_header_cache(CONTEXT *ctx, struct hcache_gc *gc)
+{
+  int rc = -1;
+#if USE_HCACHE
+  header_cache_t *hc;
+  HASH *keys;
+  BUFFER *key;
+  const char *p;
+  int i;
+
+  keys = hash_create(MAX(ctx->msgcount, 1), MUTT_HASH_STRDUP_KEYS);
+  key = mutt_buffer_pool_get();
+  for (i = 0; i < ctx->msgcount; i++)
+  {
+    p = ctx->hdrs[i]->path;
+    if (ctx->magic == MUTT_MAILDIR)
+    {
+      /* records are keyed on path + 3 up to the flags, and the
+       * purge passes keys without their leading '/' */
+      p += 4;
+      mutt_buffer_substrcpy(key, p, p + maildir_hcache_keylen(p));
+      p = mutt_b2s(key);
+    }
+    hash_insert(keys, p, ctx->hdrs[i]);
+  }
+  mutt_buffer_pool_release(&key);
+
+  hc = mutt_hcache_open(HeaderCache, ctx->path, NULL);
+  rc = mutt_hcache_purge(hc, mutt_hcache_keep_listed, keys, gc);
   mutt_hcache_close(hc);
+  hash_destroy(&keys, NULL);
 #endif
   return rc;
 }
@@ -2814,6 +2893,9 @@ struct mx_ops mx_maildir_ops = {
   .check = maildir_check_mailbox,
   .sync = mh_sync_mailbox,
   .save_to_header_cache = maildir_save_to_header_cache,
+  .begin_header_cache = mh_begin_header_cache,
+  .commit_header_cache = mh_commit_header_cache,
+  .purge_header_cache = mh_purge_header_cache,
 };
 
 struct mx_ops mx_mh_ops = {
@@ -2827,4 +2909,7 @@ struct mx_ops mx_mh_ops = {
   .check = mh_check_mailbox,
   .sync = mh_sync_mailbox,
   .save_to_header_cache = mh_save_to_header_cache,
+  .begin_header_cache = mh_begin_header_cache,
+  .commit_header_cache = mh_commit_header_cache,
+  .purge_header_cache = mh_purge_header_cache,
 };
@@ -46,6 +46,14 @@ typedef struct monitor_t
   ino_t st_ino;
   short magic;
   int descr;
+
+  /* message counts of a maildir subdirectory, kept up to date from
+   * the events of the watch.  stats_time is when they were last set by
+   * a directory scan, 0 if they are not valid. */
+  int msg_count;
+  int msg_unread;
+  int msg_flagged;
+  time_t stats_time;
 } MONITOR;
 
 static int INotifyFd = -1;
@@ -67,9 +75,17 @@ typedef struct monitorinfo_t
   BUFFER *_pathbuf; /* access via path only (maybe not initialized) */
 } MONITORINFO;
 
-#define INOTIFY_MASK_DIR  (IN_MOVED_TO | IN_ATTRIB | IN_CLOSE_WRITE | IN_ISDIR)
+#define INOTIFY_MASK_DIR  (IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE | \
+                           IN_ATTRIB | IN_CLOSE_WRITE | IN_ISDIR)
 #define INOTIFY_MASK_FILE IN_CLOSE_WRITE
 
+/* events that signal a change of the open mailbox */
+#define INOTIFY_MASK_CONTEXT (IN_MOVED_TO | IN_ATTRIB | IN_CLOSE_WRITE)
+
+/* maildir counts maintained from events are rescanned after this
+ * many seconds, to correct anything the events missed */
+#define MONITOR_STATS_RESCAN 600
+
 static void mutt_poll_fd_add(int fd, short events)
 {
   int i = 0;
@@ -230,8 +246,106 @@ static int monitor_handle_ignore(int descr)
   return new_descr;
 }
 
+/* Adds (dir = 1) or removes (dir = -1) a maildir message file name to
+ * or from the counts of a monitor, like buffy_maildir_check_dir() counts it.
+ */
+static void monitor_stats_update(MONITOR *monitor, const char *name, int dir)
+{
+  const char *p;
+
+  if (*name == '.')
+    return;
+
+  p = strstr(name, ":2,");
+  if (p && strchr(p + 3, 'T'))
+    return;
+
+  monitor->msg_count += dir;
+  if (p && strchr(p + 3, 'F'))
+    monitor->msg_flagged += dir;
+  if (!p || !strchr(p + 3, 'S'))
+    monitor->msg_unread += dir;
+
+  if (monitor->msg_count < 0 || monitor->msg_unread < 0 ||
+      monitor->msg_flagged < 0)
+    monitor->stats_time = 0;
+}
+
+static void monitor_handle_event(const struct inotify_event *event)
+{
+  MONITOR *iter;
+
+  muttdbg(5, "monitor:  + detail: descriptor=%d mask=0x%x",
+          event->wd, event->mask);
+
+  if (event->mask & IN_Q_OVERFLOW)
+  {
+    /* events were lost: the counts have to be rescanned */
+    muttdbg(2, "monitor: event queue overflow");
+    for (iter = Monitor; iter; iter = iter->next)
+      iter->stats_time = 0;
+    return;
+  }
+
+  if (event->mask & IN_IGNORED)
+  {
+    monitor_handle_ignore(event->wd);
+    return;
+  }
+
+  if (event->wd == MonitorContextDescriptor &&
+      (event->mask & INOTIFY_MASK_CONTEXT))
+    MonitorContextChanged = 1;
+
+  if (!event->len || (event->mask & IN_ISDIR) ||
+      !(event->mask & (IN_CREATE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM)))
+    return;
+
+  for (iter = Monitor; iter && iter->descr != event->wd; iter = iter->next)
+    ;
+  if (!iter || !iter->stats_time)
+    return;
+
+  /* a flag change is a rename, i.e. IN_MOVED_FROM followed by IN_MOVED_TO */
+  monitor_stats_update(iter, event->name,
+                       (event->mask & (IN_CREATE | IN_MOVED_TO)) ? 1 : -1);
+}
+
 #define EVENT_BUFLEN MAX(4096, sizeof(struct inotify_event) + NAME_MAX + 1)
 
+/* Reads and handles all pending inotify events.
+ * Returns 1 if there were any.
+ */
+static int monitor_read_events(void)
+{
+  int len, rc = 0;
+  char *ptr;
+  char buf[EVENT_BUFLEN]
+    __attribute__ ((aligned(__alignof__(struct inotify_event))));
+  const struct inotify_event *event;
+
+  FOREVER
+  {
+    len = read(INotifyFd, buf, sizeof(buf));
+    if (len == -1)
+    {
+      if (errno != EAGAIN)
+        mutt_errno_dbg(2, "monitor: read inotify events failed");
+      break;
+    }
+
+    rc = 1;
+    for (ptr = buf; ptr < buf + len;
+         ptr += sizeof(struct inotify_event) + event->len)
+    {
+      event = (const struct inotify_event *) ptr;
+      monitor_handle_event(event);
+    }
+  }
+
+  return rc;
+}
+
 /* mutt_monitor_poll: Waits for I/O ready file descriptors or signals.
  *
  * return values:
@@ -247,8 +361,6 @@ static int monitor_handle_ignore(int descr)
 int mutt_monitor_poll(void)
 {
   int rc = 0, fds, i, inputReady;
-  char buf[EVENT_BUFLEN]
-    __attribute__ ((aligned(__alignof__(struct inotify_event))));
 
   MonitorFilesChanged = 0;
 
@@ -280,32 +392,7 @@ int mutt_monitor_poll(void)
           {
             MonitorFilesChanged = 1;
             muttdbg(3, "monitor: file change(s) detected");
-            int len;
-            char *ptr = buf;
-            const struct inotify_event *event;
-
-            FOREVER
-            {
-              len = read(INotifyFd, buf, sizeof(buf));
-              if (len == -1)
-              {
-                if (errno != EAGAIN)
-                  mutt_errno_dbg(2, "monitor: read inotify events failed");
-                break;
-              }
-
-              while (ptr < buf + len)
-              {
-                event = (const struct inotify_event *) ptr;
-                muttdbg(5, "monitor:  + detail: descriptor=%d mask=0x%x",
-                        event->wd, event->mask);
-                if (event->mask & IN_IGNORED)
-                  monitor_handle_ignore(event->wd);
-                else if (event->wd == MonitorContextDescriptor)
-                  MonitorContextChanged = 1;
-                ptr += sizeof(struct inotify_event) + event->len;
-              }
-            }
+            monitor_read_events();
           }
         }
       }
@@ -324,6 +411,7 @@ int mutt_monitor_poll(void)
 #define RESOLVERES_FAIL_STAT      -1
 
 /* monitor_resolve: resolve monitor entry match by BUFFY, or - if NULL - by Context.
+ * For maildir, subdir selects the directory to watch ("new" or "cur").
  *
  * return values:
  *      >=0   mailbox is valid and locally accessible:
@@ -332,7 +420,7 @@ int mutt_monitor_poll(void)
  *       -2   magic not set
  *       -1   stat() failed (see errno; MONITORINFO fields: magic, isdir, path)
  */
-static int monitor_resolve(MONITORINFO *info, BUFFY *buffy)
+static int monitor_resolve(MONITORINFO *info, BUFFY *buffy, const char *subdir)
 {
   MONITOR *iter;
   char *fmt = NULL;
@@ -360,7 +448,7 @@ static int monitor_resolve(MONITORINFO *info, BUFFY *buffy)
   else if (info->magic == MUTT_MAILDIR)
   {
     info->isdir = 1;
-    fmt = "%s/new";
+    fmt = "%s/%s";
   }
   else
   {
@@ -373,7 +461,7 @@ static int monitor_resolve(MONITORINFO *info, BUFFY *buffy)
   {
     if (!info->_pathbuf)
       info->_pathbuf = mutt_buffer_new();
-    mutt_buffer_printf(info->_pathbuf, fmt, info->path);
+    mutt_buffer_printf(info->_pathbuf, fmt, info->path, subdir);
     info->path = mutt_b2s(info->_pathbuf);
   }
   if (stat(info->path, &sb) != 0)
@@ -390,13 +478,7 @@ static int monitor_resolve(MONITORINFO *info, BUFFY *buffy)
   return iter ? RESOLVERES_OK_EXISTING : RESOLVERES_OK_NOTEXISTING;
 }
 
-/* mutt_monitor_add: add file monitor from BUFFY, or - if NULL - from Context.
- *
- * return values:
- *       0   success: new or already existing monitor
- *      -1   failed:  no mailbox, inaccessible file, create monitor/watcher failed
- */
-int mutt_monitor_add(BUFFY *buffy)
+static int monitor_add(BUFFY *buffy, const char *subdir)
 {
   MONITORINFO info;
   uint32_t mask;
@@ -404,7 +486,7 @@ int mutt_monitor_add(BUFFY *buffy)
 
   monitor_info_init(&info);
 
-  descr = monitor_resolve(&info, buffy);
+  descr = monitor_resolve(&info, buffy, subdir);
   if (descr != RESOLVERES_OK_NOTEXISTING)
   {
     if (!buffy && (descr == RESOLVERES_OK_EXISTING))
@@ -433,14 +515,25 @@ cleanup:
   return rc;
 }
 
-/* mutt_monitor_remove: remove file monitor from BUFFY, or - if NULL - from Context.
+/* mutt_monitor_add: add file monitor from BUFFY, or - if NULL - from Context.
+ * For a maildir BUFFY, cur/ is watched as well to keep its counts.
  *
  * return values:
- *       0   monitor removed (not shared)
- *       1   monitor not removed (shared)
- *       2   no monitor
+ *       0   success: new or already existing monitor
+ *      -1   failed:  no mailbox, inaccessible file, create monitor/watcher failed
  */
-int mutt_monitor_remove(BUFFY *buffy)
+int mutt_monitor_add(BUFFY *buffy)
+{
+  int rc;
+
+  rc = monitor_add(buffy, "new");
+  if (rc == 0 && buffy && buffy->magic == MUTT_MAILDIR)
+    monitor_add(buffy, "cur");
+
+  return rc;
+}
+
+static int monitor_remove(BUFFY *buffy, const char *subdir)
 {
   MONITORINFO info, info2;
   int rc = 0;
@@ -454,7 +547,7 @@ int mutt_monitor_remove(BUFFY *buffy)
     MonitorContextChanged = 0;
   }
 
-  if (monitor_resolve(&info, buffy) != RESOLVERES_OK_EXISTING)
+  if (monitor_resolve(&info, buffy, subdir) != RESOLVERES_OK_EXISTING)
   {
     rc = 2;
     goto cleanup;
@@ -464,7 +557,7 @@ int mutt_monitor_remove(BUFFY *buffy)
   {
     if (buffy)
     {
-      if (monitor_resolve(&info2, NULL) == RESOLVERES_OK_EXISTING
+      if (monitor_resolve(&info2, NULL, "new") == RESOLVERES_OK_EXISTING
           && info.st_ino == info2.st_ino && info.st_dev == info2.st_dev)
       {
         rc = 1;
@@ -492,3 +585,87 @@ cleanup:
   monitor_info_free(&info2);
   return rc;
 }
+
+/* mutt_monitor_remove: remove file monitor from BUFFY, or - if NULL - from Context.
+ *
+ * return values:
+ *       0   monitor removed (not shared)
+ *       1   monitor not removed (shared)
+ *       2   no monitor
+ */
+int mutt_monitor_remove(BUFFY *buffy)
+{
+  int rc;
+
+  rc = monitor_remove(buffy, "new");
+  if (buffy && buffy->magic == MUTT_MAILDIR)
+    monitor_remove(buffy, "cur");
+
+  return rc;
+}
+
+/* mutt_monitor_maildir_stats: get the counts of a maildir BUFFY from the
+ * counts kept for its new/ and cur/ watches.
+ *
+ * return values:
+ *       0   msg_count, msg_unread and msg_flagged of buffy were set
+ *      -1   no valid counts: the directories have to be scanned
+ */
+int mutt_monitor_maildir_stats(BUFFY *buffy)
+{
+  MONITORINFO info;
+  MONITOR *dirs[2];
+  time_t now;
+  int i, rc = -1;
+
+  if (INotifyFd == -1 || buffy->magic != MUTT_MAILDIR)
+    return -1;
+
+  /* pick up events that haven't been read yet */
+  monitor_read_events();
+
+  monitor_info_init(&info);
+  now = time(NULL);
+  for (i = 0; i < 2; i++)
+  {
+    if (monitor_resolve(&info, buffy, i ? "cur" : "new") != RESOLVERES_OK_EXISTING
+        || !info.monitor->stats_time
+        || now - info.monitor->stats_time >= MONITOR_STATS_RESCAN)
+      goto cleanup;
+    dirs[i] = info.monitor;
+  }
+
+  buffy->msg_count   = dirs[0]->msg_count + dirs[1]->msg_count;
+  buffy->msg_unread  = dirs[0]->msg_unread + dirs[1]->msg_unread;
+  buffy->msg_flagged = dirs[0]->msg_flagged + dirs[1]->msg_flagged;
+  rc = 0;
+
+cleanup:
+  monitor_info_free(&info);
+  return rc;
+}
+
+/* mutt_monitor_maildir_seed: set the counts of a maildir subdirectory
+ * after it has been scanned.  Later events update them.
+ */
+void mutt_monitor_maildir_seed(BUFFY *buffy, const char *subdir,
+                               int count, int unread, int flagged)
+{
+  MONITORINFO info;
+
+  if (INotifyFd == -1 || buffy->magic != MUTT_MAILDIR)
+    return;
+
+  /* events for files the scan has already seen must not be counted again */
+  monitor_read_events();
+
+  monitor_info_init(&info);
+  if (monitor_resolve(&info, buffy, subdir) == RESOLVERES_OK_EXISTING)
+  {
+    info.monitor->msg_count   = count;
+    info.monitor->msg_unread  = unread;
+    info.monitor->msg_flagged = flagged;
+    info.monitor->stats_time  = time(NULL);
+  }
+  monitor_info_free(&info);
+}
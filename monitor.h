@@ -25,6 +25,9 @@ WHERE int MonitorContextChanged;
 #ifdef _BUFFY_H
 int mutt_monitor_add(BUFFY *b);
 int mutt_monitor_remove(BUFFY *b);
+int mutt_monitor_maildir_stats(BUFFY *b);
+void mutt_monitor_maildir_seed(BUFFY *b, const char *subdir,
+                               int count, int unread, int flagged);
 #endif
 int mutt_monitor_poll(void);
 
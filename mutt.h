@@ -429,6 +429,7 @@ enum
   OPTFORWQUOTE,
 #ifdef USE_HCACHE
   OPTHCACHEVERIFY,
+  OPTHCACHESYNC,
 #if defined(HAVE_QDBM) || defined(HAVE_TC) || defined(HAVE_KC)
   OPTHCACHECOMPRESS,
 #endif /* HAVE_QDBM */
@@ -660,9 +661,20 @@ typedef struct list_t
   struct list_t *next;
 } LIST;
 
+/* The head of an RX_LIST or REPLACE_LIST caches all patterns of the list
+ * combined into one expression, see mutt_match_rx_list().
+ */
+typedef struct rx_prefilter_t
+{
+  regex_t *rx;          /* NULL if the list can't be combined */
+  unsigned int gen;     /* RxListGeneration rx was built for */
+} RX_PREFILTER;
+
 typedef struct rx_list_t
 {
   REGEXP *rx;
+  int flags;            /* regcomp() flags rx was compiled with */
+  RX_PREFILTER prefilter;
   struct rx_list_t *next;
 } RX_LIST;
 
@@ -671,6 +683,7 @@ typedef struct replace_list_t
   REGEXP *rx;
   int     nmatch;
   char   *template;
+  RX_PREFILTER prefilter;
   struct replace_list_t *next;
 } REPLACE_LIST;
 
@@ -681,6 +694,7 @@ void mutt_free_list(LIST **);
 void mutt_free_list_generic(LIST **list, void(*data_free)(char **));
 void mutt_free_rx_list(RX_LIST **);
 void mutt_free_replace_list(REPLACE_LIST **);
+void mutt_free_rx_prefilter(RX_PREFILTER *);
 LIST *mutt_copy_list(LIST *);
 int mutt_matches_ignore(const char *, LIST *);
 
@@ -865,6 +879,23 @@ typedef struct body
 /* #3279: AIX defines conflicting struct thread */
 typedef struct mutt_thread THREAD;
 
+/* This is used when a message is repeatedly pattern matched against.
+ * e.g. for color, scoring, hooks.  It caches a few of the potentially slow
+ * operations.
+ * Each entry has a value of 0 = unset, 1 = false, 2 = true
+ */
+typedef struct
+{
+  unsigned char list_all;          /* ^~l */
+  unsigned char list_one;          /*  ~l */
+  unsigned char sub_all;           /* ^~u */
+  unsigned char sub_one;           /*  ~u */
+  unsigned char pers_recip_all;    /* ^~p */
+  unsigned char pers_recip_one;    /*  ~p */
+  unsigned char pers_from_all;     /* ^~P */
+  unsigned char pers_from_one;     /*  ~P */
+} pattern_cache_t;
+
 typedef struct header
 {
   unsigned int security : 14;  /* bit 0-10:   flags
@@ -888,6 +919,7 @@ typedef struct header
   unsigned int threaded : 1;            /* used for threading */
   unsigned int display_subject : 1;     /* used for threading */
   unsigned int recip_valid : 1;         /* is_recipient is valid */
+  unsigned int color_valid : 1;         /* color is valid */
   unsigned int active : 1;              /* message is not to be removed */
   unsigned int trash : 1;               /* message is marked as trashed on disk.
                                          * This flag is used by the maildir_trash
@@ -906,47 +938,71 @@ typedef struct header
   /* tells whether the attachment count is valid */
   unsigned int attach_valid : 1;
 
+  /* mime_skel hasn't been written to the header cache yet */
+  unsigned int mime_skel_dirty : 1;
+
   /* the following are used to support collapsing threads  */
   unsigned int collapsed : 1;   /* is this message part of a collapsed thread? */
   unsigned int limited : 1;     /* is this message in a limited view?  */
-  size_t num_hidden;            /* number of hidden messages in this view.
-                                 * only valid when collapsed is set. */
-
-  short recipient;              /* user_is_recipient()'s return value, cached */
-
-  COLOR_ATTR color;             /* color-pair to use when displaying in the index */
 
+  /* The fields most used by sorting, limiting and drawing the index
+   * follow the flags, so scanning all headers of a large mailbox touches
+   * as few cache lines as possible.  Rarely used fields come last. */
   time_t date_sent;             /* time when the message was sent (UTC) */
   time_t received;              /* time when the message was placed in the mailbox */
-  LOFF_T offset;                /* where in the stream does this message begin? */
-  int lines;                    /* how many lines in the body of this message? */
+  THREAD *thread;
+  ENVELOPE *env;                /* envelope information */
+  BODY *content;                /* list of MIME parts */
   int index;                    /* the absolute (unsorted) message number */
   int msgno;                    /* number displayed to the user */
   int virtual;                  /* virtual message number */
   int score;
-  ENVELOPE *env;                /* envelope information */
-  BODY *content;                /* list of MIME parts */
-  char *path;
 
-  char *tree;                   /* character string to print thread tree */
-  THREAD *thread;
+  int lines;                    /* how many lines in the body of this message? */
+  short recipient;              /* user_is_recipient()'s return value, cached */
 
   /* Number of qualifying attachments in message, if attach_valid */
   short attach_total;
 
+  size_t num_hidden;            /* number of hidden messages in this view.
+                                 * only valid when collapsed is set. */
+
+  COLOR_ATTR color;             /* color-pair to use when displaying in the index */
+
+  /* cached pattern results shared by index coloring and scoring, valid
+   * while pattern_cache_gen matches PatternCacheGeneration */
+  pattern_cache_t pattern_cache;
+  unsigned int pattern_cache_gen;
+
+  /* cached $index_format expansion, valid while index_line_gen matches
+   * IndexGeneration and the format flags are unchanged */
+  unsigned int index_line_gen;
+  format_flag index_line_flags;
+  char *index_line;
+
+  char *tree;                   /* character string to print thread tree */
+  LOFF_T offset;                /* where in the stream does this message begin? */
+  char *path;
+
+  /* MIME structure of a multipart message, one "depth type disposition
+   * type/subtype" line per part.  Set by mutt_count_body_parts() and
+   * stored in the header cache so the parts can be counted and matched
+   * without reopening the message. */
+  char *mime_skel;
+
 #ifdef MIXMASTER
   LIST *chain;
 #endif
 
-#ifdef USE_POP
-  int refno;                    /* message number on server */
-#endif
-
 #if defined USE_POP || defined USE_IMAP
   void *data;                   /* driver-specific data */
 #endif
 
   char *maildir_flags;          /* unknown maildir flags */
+
+#ifdef USE_POP
+  int refno;                    /* message number on server */
+#endif
 } HEADER;
 
 struct mutt_thread
@@ -1016,23 +1072,6 @@ typedef struct pattern_t
   } p;
 } pattern_t;
 
-/* This is used when a message is repeatedly pattern matched against.
- * e.g. for color, scoring, hooks.  It caches a few of the potentially slow
- * operations.
- * Each entry has a value of 0 = unset, 1 = false, 2 = true
- */
-typedef struct
-{
-  int list_all;          /* ^~l */
-  int list_one;          /*  ~l */
-  int sub_all;           /* ^~u */
-  int sub_one;           /*  ~u */
-  int pers_recip_all;    /* ^~p */
-  int pers_recip_one;    /*  ~p */
-  int pers_from_all;     /* ^~P */
-  int pers_from_one;     /*  ~P */
-} pattern_cache_t;
-
 /* ACL Rights */
 enum
 {
@@ -1053,6 +1092,7 @@ enum
 
 struct _context;
 struct _message;
+struct hcache_gc;
 
 /*
  * struct mx_ops - a structure to store operations on a mailbox
@@ -1077,6 +1117,11 @@ struct mx_ops
   int (*open_new_msg)(struct _message *, struct _context *, HEADER *);
   int (*msg_padding_size)(struct _context *);
   int (*save_to_header_cache)(struct _context *, struct header *);
+  /* optional: keeps the header cache open, batching the writes of
+   * save_to_header_cache() until commit_header_cache() */
+  int (*begin_header_cache)(struct _context *);
+  int (*commit_header_cache)(struct _context *);
+  int (*purge_header_cache)(struct _context *, struct hcache_gc *);
 };
 
 typedef struct _context
@@ -1141,6 +1186,8 @@ typedef struct
   FILE *fpout;
   char *prefix;
   int flags;
+  struct progress *progress;    /* decoding progress, or NULL */
+  LOFF_T progress_offset;       /* position in fpin where decoding started */
 } STATE;
 
 /* used by enter.c */
@@ -1178,6 +1225,7 @@ void state_prefix_putc(char, STATE *);
 int  state_printf(STATE *, const char *, ...);
 int state_putwc(wchar_t, STATE *);
 int state_putws(const wchar_t *, STATE *);
+void state_update_progress(STATE *);
 
 /* for attachment counter */
 typedef struct
@@ -162,7 +162,7 @@ typedef struct color_line
 #define MUTT_PROGRESS_SIZE      (1<<0)  /* traffic-based progress */
 #define MUTT_PROGRESS_MSG       (1<<1)  /* message-based progress */
 
-typedef struct
+typedef struct progress
 {
   unsigned short inc;
   unsigned short flags;
@@ -169,51 +169,109 @@ int mutt_socket_poll(CONNECTION *conn, time_t wait_secs)
   return -1;
 }
 
+/* refills conn->inbuf once it has been consumed.
+ *   Returns: 1 if there is buffered data, -1 on error or closed connection */
+static int socket_fill_buffer(CONNECTION *conn)
+{
+  if (conn->bufpos < conn->available)
+    return 1;
+
+  if (conn->fd >= 0)
+    conn->available = conn->conn_read(conn, conn->inbuf, sizeof(conn->inbuf));
+  else
+  {
+    muttdbg(1, "attempt to read from closed connection.");
+    return -1;
+  }
+  conn->bufpos = 0;
+  if (conn->available == 0)
+  {
+    mutt_error(_("Connection to %s closed"), conn->account.host);
+    mutt_sleep(2);
+  }
+  if (conn->available <= 0)
+  {
+    mutt_socket_close(conn);
+    return -1;
+  }
+  return 1;
+}
+
 /* simple read buffering to speed things up. */
 int mutt_socket_readchar(CONNECTION *conn, char *c)
 {
-  if (conn->bufpos >= conn->available)
+  if (socket_fill_buffer(conn) != 1)
+    return -1;
+  *c = conn->inbuf[conn->bufpos];
+  conn->bufpos++;
+  return 1;
+}
+
+/* reads up to len bytes of raw data.  Data already buffered in
+ * conn->inbuf is returned first.  Once that is drained, large requests
+ * are read straight into buf rather than staged through inbuf.
+ *   Returns: number of bytes read, -1 on error or closed connection */
+int mutt_socket_read(CONNECTION *conn, char *buf, size_t len)
+{
+  int n;
+
+  if (conn->bufpos >= conn->available && len >= sizeof(conn->inbuf))
   {
-    if (conn->fd >= 0)
-      conn->available = conn->conn_read(conn, conn->inbuf, sizeof(conn->inbuf));
-    else
+    if (conn->fd < 0)
     {
       muttdbg(1, "attempt to read from closed connection.");
       return -1;
     }
-    conn->bufpos = 0;
-    if (conn->available == 0)
+    n = conn->conn_read(conn, buf, len);
+    if (n == 0)
     {
       mutt_error(_("Connection to %s closed"), conn->account.host);
       mutt_sleep(2);
     }
-    if (conn->available <= 0)
+    if (n <= 0)
     {
       mutt_socket_close(conn);
       return -1;
     }
+    return n;
   }
-  *c = conn->inbuf[conn->bufpos];
-  conn->bufpos++;
-  return 1;
+
+  if (socket_fill_buffer(conn) != 1)
+    return -1;
+  n = MIN(len, (size_t)(conn->available - conn->bufpos));
+  memcpy(buf, conn->inbuf + conn->bufpos, n);
+  conn->bufpos += n;
+  return n;
 }
 
 int mutt_socket_readln_d(char *buf, size_t buflen, CONNECTION *conn, int dbg)
 {
-  char ch;
-  int i;
+  const char *start, *nl;
+  size_t i = 0, n;
 
-  for (i = 0; i < buflen-1; i++)
+  /* copy whole spans out of the input buffer rather than going
+   * through mutt_socket_readchar() for each byte */
+  while (i < buflen - 1)
   {
-    if (mutt_socket_readchar(conn, &ch) != 1)
+    if (socket_fill_buffer(conn) != 1)
     {
       buf[i] = '\0';
       return -1;
     }
 
-    if (ch == '\n')
+    start = conn->inbuf + conn->bufpos;
+    n = MIN((size_t)(conn->available - conn->bufpos), buflen - 1 - i);
+    if ((nl = memchr(start, '\n', n)) != NULL)
+    {
+      n = nl - start;
+      memcpy(buf + i, start, n);
+      i += n;
+      conn->bufpos += n + 1;
       break;
-    buf[i] = ch;
+    }
+    memcpy(buf + i, start, n);
+    i += n;
+    conn->bufpos += n;
   }
 
   /* strip \r from \r\n termination */
@@ -229,29 +287,33 @@ int mutt_socket_readln_d(char *buf, size_t buflen, CONNECTION *conn, int dbg)
 
 int mutt_socket_buffer_readln_d(BUFFER *buf, CONNECTION *conn, int dbg)
 {
-  char ch;
-  int has_cr = 0;
+  const char *start, *nl;
+  size_t n;
 
   mutt_buffer_clear(buf);
 
   FOREVER
   {
-    if (mutt_socket_readchar(conn, &ch) != 1)
+    if (socket_fill_buffer(conn) != 1)
       return -1;
 
-    if (ch == '\n')
-      break;
-
-    if (has_cr)
+    start = conn->inbuf + conn->bufpos;
+    n = conn->available - conn->bufpos;
+    if ((nl = memchr(start, '\n', n)) != NULL)
     {
-      mutt_buffer_addch(buf, '\r');
-      has_cr = 0;
+      mutt_buffer_addstr_n(buf, start, nl - start);
+      conn->bufpos += nl - start + 1;
+      break;
     }
+    mutt_buffer_addstr_n(buf, start, n);
+    conn->bufpos += n;
+  }
 
-    if (ch == '\r')
-      has_cr = 1;
-    else
-      mutt_buffer_addch(buf, ch);
+  /* strip \r from \r\n termination.  Any other \r is kept. */
+  if (mutt_buffer_len(buf) && *(buf->dptr - 1) == '\r')
+  {
+    buf->dptr--;
+    *buf->dptr = '\0';
   }
 
   muttdbg(dbg, "%d< %s", conn->fd, mutt_b2s(buf));
@@ -310,6 +310,8 @@ int mutt_remove_from_rx_list(RX_LIST **l, const char *str)
       if (ascii_strcasecmp(str, p->rx->pattern) == 0)
       {
         mutt_free_regexp(&p->rx);
+        mutt_free_rx_prefilter(&p->prefilter);
+        RxListGeneration++;
         if (last)
           last->next = p->next;
         else
@@ -398,6 +400,8 @@ void mutt_free_header(HEADER **h)
   mutt_free_body(&(*h)->content);
   FREE(&(*h)->maildir_flags);
   FREE(&(*h)->tree);
+  FREE(&(*h)->index_line);
+  FREE(&(*h)->mime_skel);
   FREE(&(*h)->path);
 #ifdef MIXMASTER
   mutt_free_list(&(*h)->chain);
@@ -1461,6 +1465,147 @@ const char *mutt_getcwd(BUFFER *cwd)
   return retval;
 }
 
+void mutt_free_rx_prefilter(RX_PREFILTER *pf)
+{
+  if (pf->rx)
+  {
+    regfree(pf->rx);
+    FREE(&pf->rx);
+  }
+  pf->gen = 0;
+}
+
+/* Lists of regular expressions (lists, subscribe, alternates, spam,
+ * subjectrx, ...) are matched with one regexec() per entry.  Most strings
+ * match none of the entries, so the head of each list caches all its
+ * patterns combined into a single alternation that rejects them with one
+ * regexec().  Only a match of the combined expression falls through to
+ * the per entry loop, which keeps the first-match semantics and the
+ * subexpression numbering of each entry.
+ */
+
+/* Returns 0 if pattern can be wrapped in a group of a larger
+ * alternation without changing what it matches. */
+static int rx_prefilter_check(const char *pattern)
+{
+  const char *p;
+  char c;
+  int depth = 0;
+
+  for (p = pattern; *p; p++)
+  {
+    if (*p == '\\')
+    {
+      /* back-references would be renumbered by the added groups */
+      if (!*++p || isdigit((unsigned char) *p))
+        return -1;
+    }
+    else if (*p == '[')
+    {
+      /* skip the bracket expression.  A leading ']' is literal. */
+      if (*++p == '^')
+        p++;
+      if (*p == ']')
+        p++;
+      for (; *p && *p != ']'; p++)
+      {
+        if (*p == '[' && (p[1] == ':' || p[1] == '.' || p[1] == '='))
+        {
+          c = p[1];
+          for (p += 2; *p && !(*p == c && p[1] == ']'); p++)
+            ;
+          if (!*p++)
+            return -1;
+        }
+      }
+      if (!*p)
+        return -1;
+    }
+    else if (*p == '(')
+      depth++;
+    else if (*p == ')' && --depth < 0)
+      return -1;
+  }
+
+  return depth ? -1 : 0;
+}
+
+static int rx_prefilter_add(BUFFER *combined, const char *pattern)
+{
+  if (rx_prefilter_check(pattern) < 0)
+    return -1;
+
+  if (mutt_buffer_len(combined))
+    mutt_buffer_addch(combined, '|');
+  mutt_buffer_addch(combined, '(');
+  mutt_buffer_addstr(combined, pattern);
+  mutt_buffer_addch(combined, ')');
+  return 0;
+}
+
+static void rx_prefilter_compile(RX_PREFILTER *pf, BUFFER *combined, int flags)
+{
+  pf->rx = safe_calloc(1, sizeof(regex_t));
+  if (REGCOMP(pf->rx, mutt_b2s(combined), flags | REG_NOSUB) != 0)
+  {
+    muttdbg(2, "unable to combine rx list: %s", mutt_b2s(combined));
+    FREE(&pf->rx);
+  }
+}
+
+static regex_t *rx_list_prefilter(RX_LIST *l)
+{
+  RX_LIST *p;
+  BUFFER *combined;
+
+  if (l->prefilter.gen == RxListGeneration)
+    return l->prefilter.rx;
+
+  mutt_free_rx_prefilter(&l->prefilter);
+  l->prefilter.gen = RxListGeneration;
+
+  /* nothing to gain for a single entry */
+  if (!l->next)
+    return NULL;
+
+  combined = mutt_buffer_pool_get();
+  for (p = l; p; p = p->next)
+    if (p->flags != l->flags || rx_prefilter_add(combined, p->rx->pattern) < 0)
+      break;
+  if (!p)
+    rx_prefilter_compile(&l->prefilter, combined, l->flags);
+  mutt_buffer_pool_release(&combined);
+
+  return l->prefilter.rx;
+}
+
+/* All REPLACE_LIST entries are compiled with REG_ICASE, see
+ * add_to_replace_list(). */
+static regex_t *replace_list_prefilter(REPLACE_LIST *l)
+{
+  REPLACE_LIST *p;
+  BUFFER *combined;
+
+  if (l->prefilter.gen == RxListGeneration)
+    return l->prefilter.rx;
+
+  mutt_free_rx_prefilter(&l->prefilter);
+  l->prefilter.gen = RxListGeneration;
+
+  if (!l->next)
+    return NULL;
+
+  combined = mutt_buffer_pool_get();
+  for (p = l; p; p = p->next)
+    if (rx_prefilter_add(combined, p->rx->pattern) < 0)
+      break;
+  if (!p)
+    rx_prefilter_compile(&l->prefilter, combined, REG_ICASE);
+  mutt_buffer_pool_release(&combined);
+
+  return l->prefilter.rx;
+}
+
 char *mutt_apply_replace(char *d, size_t dlen, char *s, REPLACE_LIST *rlist)
 {
   REPLACE_LIST *l;
@@ -1469,6 +1614,7 @@ char *mutt_apply_replace(char *d, size_t dlen, char *s, REPLACE_LIST *rlist)
   BUFFER *srcbuf, *destbuf;
   char *p;
   unsigned int n;
+  regex_t *prefilter;
 
   if (d && dlen)
     d[0] = '\0';
@@ -1476,6 +1622,18 @@ char *mutt_apply_replace(char *d, size_t dlen, char *s, REPLACE_LIST *rlist)
   if (s == NULL || *s == '\0' || (d && !dlen))
     return d;
 
+  /* if no rule matches the original string, none of the
+   * substitutions can apply */
+  if (rlist && (prefilter = replace_list_prefilter(rlist)) &&
+      regexec(prefilter, s, (size_t) 0, (regmatch_t *) 0, (int) 0) != 0)
+  {
+    if (d)
+      strfcpy(d, s, dlen);
+    else
+      d = safe_strdup(s);
+    return d;
+  }
+
   srcbuf = mutt_buffer_pool_get();
   destbuf = mutt_buffer_pool_get();
 
@@ -2150,6 +2308,21 @@ int state_putws(const wchar_t *ws, STATE *s)
   return 0;
 }
 
+/* reports how far decoding of s->fpin has got, if a progress
+ * indicator was set up for the state */
+void state_update_progress(STATE *s)
+{
+  LOFF_T pos;
+
+  if (!s->progress)
+    return;
+
+  /* handlers may temporarily swap in a decoded copy as fpin */
+  pos = ftello(s->fpin) - s->progress_offset;
+  if (pos > 0 && pos <= s->progress->size)
+    mutt_progress_update(s->progress, pos, -1);
+}
+
 void mutt_display_sanitize(char *s)
 {
   for (; *s; s++)
@@ -2315,11 +2488,14 @@ void mutt_free_rx_list(RX_LIST **list)
   RX_LIST *p;
 
   if (!list) return;
+  if (*list)
+    RxListGeneration++;
   while (*list)
   {
     p = *list;
     *list = (*list)->next;
     mutt_free_regexp(&p->rx);
+    mutt_free_rx_prefilter(&p->prefilter);
     FREE(&p);
   }
 }
@@ -2329,20 +2505,29 @@ void mutt_free_replace_list(REPLACE_LIST **list)
   REPLACE_LIST *p;
 
   if (!list) return;
+  if (*list)
+    RxListGeneration++;
   while (*list)
   {
     p = *list;
     *list = (*list)->next;
     mutt_free_regexp(&p->rx);
     FREE(&p->template);
+    mutt_free_rx_prefilter(&p->prefilter);
     FREE(&p);
   }
 }
 
 int mutt_match_rx_list(const char *s, RX_LIST *l)
 {
+  regex_t *prefilter;
+
   if (!s)  return 0;
 
+  if (l && (prefilter = rx_list_prefilter(l)) &&
+      regexec(prefilter, s, (size_t) 0, (regmatch_t *) 0, (int) 0) != 0)
+    return 0;
+
   for (; l; l = l->next)
   {
     if (regexec(l->rx->rx, s, (size_t) 0, (regmatch_t *) 0, (int) 0) == 0)
@@ -2368,9 +2553,14 @@ int mutt_match_spam_list(const char *s, REPLACE_LIST *l, char *text, int textsiz
   static int nmatch = 0;
   int tlen = 0;
   char *p;
+  regex_t *prefilter;
 
   if (!s) return 0;
 
+  if (l && (prefilter = replace_list_prefilter(l)) &&
+      regexec(prefilter, s, (size_t) 0, (regmatch_t *) 0, (int) 0) != 0)
+    return 0;
+
   for (; l; l = l->next)
   {
     /* If this pattern needs more matches, expand pmatch. */
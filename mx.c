@@ -47,6 +47,10 @@
 
 #include "buffy.h"
 
+#ifdef USE_HCACHE
+#include "hcache.h"
+#endif
+
 #ifdef USE_DOTLOCK
 #include "dotlock.h"
 #endif
@@ -719,7 +723,10 @@ void mx_fastclose_mailbox(CONTEXT *ctx)
     mutt_buffy_setnotified(ctx->path);
 
   if (ctx->mx_ops)
+  {
+    mx_store_mime_skels(ctx);
     ctx->mx_ops->close(ctx);
+  }
 
 #ifdef USE_COMPRESSED
   mutt_free_compress_info(ctx);
@@ -1110,6 +1117,8 @@ void mx_update_tables(CONTEXT *ctx, int committing)
 {
   int i, j, padding;
 
+  mutt_invalidate_index_lines();
+
   /* update memory to reflect the new state of the mailbox */
   ctx->vcount = 0;
   ctx->vsize = 0;
@@ -1495,6 +1504,8 @@ void mx_update_context(CONTEXT *ctx, int new_messages)
   HEADER *h;
   int msgno;
 
+  mutt_invalidate_index_lines();
+
   for (msgno = ctx->msgcount - new_messages; msgno < ctx->msgcount; msgno++)
   {
     h = ctx->hdrs[msgno];
@@ -1620,4 +1631,49 @@ int mx_save_to_header_cache(CONTEXT *ctx, HEADER *h)
   return ctx->mx_ops->save_to_header_cache(ctx, h);
 }
 
+/* Writes the MIME skeletons that mutt_count_body_parts() recorded since
+ * the headers were last stored.  Messages with unsynced changes are
+ * skipped, since the flags cached for IMAP are trusted when CONDSTORE or
+ * QRESYNC is in use. */
+void mx_store_mime_skels(CONTEXT *ctx)
+{
+  HEADER *h;
+  int i, batch = 0;
+
+  if (!ctx->mx_ops || !ctx->mx_ops->save_to_header_cache)
+    return;
+
+  for (i = 0; i < ctx->msgcount; i++)
+  {
+    h = ctx->hdrs[i];
+    if (!h || !h->mime_skel_dirty || h->changed || h->deleted)
+      continue;
+
+    /* 1 if the writes are batched, -1 if the driver can't batch them */
+    if (!batch)
+      batch = (ctx->mx_ops->begin_header_cache &&
+               ctx->mx_ops->begin_header_cache(ctx) == 0) ? 1 : -1;
+
+    mx_save_to_header_cache(ctx, h);
+  }
+
+  if (batch == 1)
+    ctx->mx_ops->commit_header_cache(ctx);
+}
+
+/* Drops stale records from the folder's header cache, see
+ * mutt_hcache_purge(). */
+int mx_purge_header_cache(CONTEXT *ctx, struct hcache_gc *gc)
+{
+  if (!ctx->mx_ops || !ctx->mx_ops->purge_header_cache)
+  {
+#ifdef USE_HCACHE
+    gc->skipped = _("this folder type has no header cache");
+#endif
+    return -1;
+  }
+
+  return ctx->mx_ops->purge_header_cache(ctx, gc);
+}
+
 /* vim: set sw=2: */
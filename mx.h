@@ -51,6 +51,7 @@ WHERE short DefaultMagic INITVAL(MUTT_MBOX);
 int mbox_lock_mailbox(CONTEXT *, int, int);
 int mbox_parse_mailbox(CONTEXT *);
 int mmdf_parse_mailbox(CONTEXT *);
+int mbox_parse_appended(const char *, LOFF_T *, struct timespec *, int *, int *, int *);
 void mbox_unlock_mailbox(CONTEXT *);
 int mbox_check_empty(const char *);
 void mbox_reset_atime(CONTEXT *, struct stat *);
@@ -1128,6 +1128,7 @@ static int grok_ansi(unsigned char *buf, int pos, ansi_attr *a)
 void mutt_buffer_strip_formatting(BUFFER *dest, const char *src, int strip_markers)
 {
   const char *s = src;
+  size_t n;
 
   mutt_buffer_clear(dest);
 
@@ -1164,7 +1165,12 @@ void mutt_buffer_strip_formatting(BUFFER *dest, const char *src, int strip_marke
         ;
     }
     else
-      mutt_buffer_addch(dest, *s++);
+    {
+      /* copy up to the next character that may start formatting */
+      n = strcspn(s + 1, "\010\033") + 1;
+      mutt_buffer_addstr_n(dest, s, n);
+      s += n;
+    }
   }
 }
 
@@ -1315,7 +1321,7 @@ static int format_line(struct line_t **lineInfo, int n, unsigned char *buf,
   int space = -1; /* index of the last space or TAB */
   int col;
   size_t k;
-  int ch, vch, last_special = -1, special = 0, t;
+  int ch, vch, last_special = -1, special = 0, t, run;
   wchar_t wc;
   mbstate_t mbstate;
   int wrap_cols;
@@ -1352,6 +1358,26 @@ static int format_line(struct line_t **lineInfo, int n, unsigned char *buf,
           break;
     }
 
+    /* When only laying out the line, runs of printable ASCII can be
+     * measured without decoding them one at a time.  A character
+     * followed by a backspace is left to the overstrike code below. */
+    if (!pa && mbsinit(&mbstate))
+    {
+      for (run = ch; ch < cnt && col < wrap_cols &&
+             buf[ch] >= 0x20 && buf[ch] < 0x7f &&
+             (ch + 1 >= cnt || buf[ch+1] != '\b'); ch++, vch++, col++)
+      {
+        if (buf[ch] == ' ')
+          space = ch;
+      }
+      if (ch > run)
+      {
+        special = 0;
+        k = 0;
+        continue;
+      }
+    }
+
     /* is anything left to do? */
     if (ch >= cnt)
       break;
@@ -1535,7 +1561,9 @@ display_line(FILE *f, LOFF_T *last_pos, struct line_t **lineInfo, int n,
 
   if (*last == *max)
   {
-    safe_realloc(lineInfo, sizeof(struct line_t) * (*max += LINES));
+    /* grow geometrically: <bottom> and searches on long messages
+     * would otherwise reallocate the array every screenful */
+    safe_realloc(lineInfo, sizeof(struct line_t) * (*max += MAX(LINES, *max / 2)));
     for (ch = *last; ch < *max ; ch++)
     {
       memset(&((*lineInfo)[ch]), 0, sizeof(struct line_t));
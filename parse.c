@@ -38,10 +38,26 @@
 #include <sys/stat.h>
 #include <stdlib.h>
 
-static void _parse_part(FILE *fp, BODY *b, int *counter);
-static BODY *_parse_messageRFC822(FILE *fp, BODY *parent, int *counter);
+/* State shared by one run of the MIME structure parser.
+ *
+ * The outermost multipart scan records the offset of every body line
+ * starting with "--".  Nested multiparts lie inside that range, so their
+ * boundaries are looked up in this index instead of reading the part
+ * bodies from the file again for each level of nesting.
+ */
+struct mime_scan
+{
+  int counter;          /* number of body parts seen so far */
+  LOFF_T *dashes;       /* sorted offsets of lines beginning with "--" */
+  size_t ndashes;
+  size_t dashmax;
+  short indexed;        /* dashes covers all nested multipart bodies */
+};
+
+static void _parse_part(FILE *fp, BODY *b, struct mime_scan *scan);
+static BODY *_parse_messageRFC822(FILE *fp, BODY *parent, struct mime_scan *scan);
 static BODY *_parse_multipart(FILE *fp, const char *boundary, LOFF_T end_off,
-                              int digest, int *counter);
+                              int digest, struct mime_scan *scan);
 
 
 /* Reads an arbitrarily long header field, and looks ahead for continuation
@@ -596,7 +612,7 @@ BODY *mutt_read_mime_header(FILE *fp, int digest)
   return (p);
 }
 
-static void _parse_part(FILE *fp, BODY *b, int *counter)
+static void _parse_part(FILE *fp, BODY *b, struct mime_scan *scan)
 {
   char *bound = 0;
   static unsigned short recurse_level = 0;
@@ -627,7 +643,7 @@ static void _parse_part(FILE *fp, BODY *b, int *counter)
       b->parts =  _parse_multipart(fp, bound,
                                    b->offset + b->length,
                                    ascii_strcasecmp("digest", b->subtype) == 0,
-                                   counter);
+                                   scan);
       break;
 
     case TYPEMESSAGE:
@@ -635,7 +651,7 @@ static void _parse_part(FILE *fp, BODY *b, int *counter)
       {
         fseeko(fp, b->offset, SEEK_SET);
         if (mutt_is_message_type(b->type, b->subtype))
-          b->parts = _parse_messageRFC822(fp, b, counter);
+          b->parts = _parse_messageRFC822(fp, b, scan);
         else if (ascii_strcasecmp(b->subtype, "external-body") == 0)
           b->parts = mutt_read_mime_header(fp, 0);
         else
@@ -668,7 +684,7 @@ bail:
  * NOTE: this assumes that `parent->length' has been set!
  */
 
-static BODY *_parse_messageRFC822(FILE *fp, BODY *parent, int *counter)
+static BODY *_parse_messageRFC822(FILE *fp, BODY *parent, struct mime_scan *scan)
 {
   BODY *msg;
 
@@ -686,10 +702,78 @@ static BODY *_parse_messageRFC822(FILE *fp, BODY *parent, int *counter)
   if (msg->length < 0)
     msg->length = 0;
 
-  _parse_part(fp, msg, counter);
+  _parse_part(fp, msg, scan);
   return (msg);
 }
 
+/* Returns 1 if pos is at the beginning of a line, leaving fp at pos. */
+static int mime_line_start(FILE *fp, LOFF_T pos)
+{
+  if (pos == 0)
+    return 1;
+  fseeko(fp, pos - 1, SEEK_SET);
+  return fgetc(fp) == '\n';
+}
+
+/* Reads the next body line starting with "--" that begins before end_off.
+ *
+ * When the scan is indexed, the line is looked up in scan->dashes.  Lines
+ * are split by fgets() exactly as in the recording pass as long as we
+ * start reading at the beginning of a line, so any other position is
+ * handled by reading forward until we are back in step.  The recording
+ * pass appends the offset of every such line to scan->dashes.
+ *
+ * Returns 1 if a line was read into buffer, 0 otherwise.
+ */
+static int mime_read_dash_line(FILE *fp, char *buffer, size_t buflen,
+                               LOFF_T end_off, struct mime_scan *scan,
+                               int record)
+{
+  LOFF_T pos;
+  size_t lo, hi, mid;
+
+  FOREVER
+  {
+    if ((pos = ftello(fp)) >= end_off)
+      return 0;
+
+    if (scan->indexed && mime_line_start(fp, pos))
+    {
+      lo = 0;
+      hi = scan->ndashes;
+      while (lo < hi)
+      {
+        mid = (lo + hi) / 2;
+        if (scan->dashes[mid] < pos)
+          lo = mid + 1;
+        else
+          hi = mid;
+      }
+      if (lo == scan->ndashes || scan->dashes[lo] >= end_off)
+        return 0;
+      fseeko(fp, scan->dashes[lo], SEEK_SET);
+      return fgets(buffer, buflen, fp) != NULL;
+    }
+
+    if (fgets(buffer, buflen, fp) == NULL)
+      return 0;
+
+    if (buffer[0] == '-' && buffer[1] == '-')
+    {
+      if (record)
+      {
+        if (scan->ndashes == scan->dashmax)
+        {
+          scan->dashmax = scan->dashmax ? scan->dashmax * 2 : 64;
+          safe_realloc(&scan->dashes, scan->dashmax * sizeof(LOFF_T));
+        }
+        scan->dashes[scan->ndashes++] = pos;
+      }
+      return 1;
+    }
+  }
+}
+
 /* parse a multipart structure
  *
  * args:
@@ -704,7 +788,7 @@ static BODY *_parse_messageRFC822(FILE *fp, BODY *parent, int *counter)
  */
 
 static BODY *_parse_multipart(FILE *fp, const char *boundary, LOFF_T end_off,
-                              int digest, int *counter)
+                              int digest, struct mime_scan *scan)
 {
 #ifdef SUN_ATTACHMENT
   int lines;
@@ -714,6 +798,7 @@ static BODY *_parse_multipart(FILE *fp, const char *boundary, LOFF_T end_off,
   char buffer[LONG_STRING];
   BODY *head = 0, *last = 0, *new = 0;
   int final = 0; /* did we see the ending boundary? */
+  int record, complete = 1;
 
   if (!boundary)
   {
@@ -721,15 +806,19 @@ static BODY *_parse_multipart(FILE *fp, const char *boundary, LOFF_T end_off,
     return (NULL);
   }
 
+  /* the outermost scan reads the whole body and records the candidate
+   * boundary lines for the nested parts */
+  if ((record = !scan->indexed))
+    scan->ndashes = 0;
+
   blen = mutt_strlen(boundary);
-  while (ftello(fp) < end_off && fgets(buffer, LONG_STRING, fp) != NULL)
+  while (mime_read_dash_line(fp, buffer, sizeof(buffer), end_off, scan, record))
   {
     len = mutt_strlen(buffer);
 
     crlf =  (len > 1 && buffer[len - 2] == '\r') ? 1 : 0;
 
-    if (buffer[0] == '-' && buffer[1] == '-' &&
-        mutt_strncmp(buffer + 2, boundary, blen) == 0)
+    if (mutt_strncmp(buffer + 2, boundary, blen) == 0)
     {
       if (last)
       {
@@ -763,6 +852,7 @@ static BODY *_parse_multipart(FILE *fp, const char *boundary, LOFF_T end_off,
           for ( ; lines; lines-- )
             if (ftello(fp) >= end_off || fgets(buffer, LONG_STRING, fp) == NULL)
               break;
+          complete = 0; /* the skipped lines were not recorded */
         }
 #endif
 
@@ -774,6 +864,7 @@ static BODY *_parse_multipart(FILE *fp, const char *boundary, LOFF_T end_off,
         if (new->offset > end_off)
         {
           mutt_free_body(&new);
+          complete = 0;
           break;
         }
         if (head)
@@ -789,8 +880,11 @@ static BODY *_parse_multipart(FILE *fp, const char *boundary, LOFF_T end_off,
          * contains thousands of tiny parts before the memory and data
          * structures are allocated.
          */
-        if (++(*counter) >= MUTT_MIME_MAX_PARTS)
+        if (++(scan->counter) >= MUTT_MIME_MAX_PARTS)
+        {
+          complete = 0;
           break;
+        }
       }
     }
   }
@@ -799,32 +893,49 @@ static BODY *_parse_multipart(FILE *fp, const char *boundary, LOFF_T end_off,
   if (last && last->length == 0 && !final)
     last->length = end_off - last->offset;
 
+  /* nested parts may only use the index if the whole range was recorded */
+  if (record)
+    scan->indexed = complete;
+
   /* parse recursive MIME parts */
   for (last = head; last; last = last->next)
-    _parse_part(fp, last, counter);
+    _parse_part(fp, last, scan);
+
+  if (record)
+    scan->indexed = 0;
 
   return (head);
 }
 
 void mutt_parse_part(FILE *fp, BODY *b)
 {
-  int counter = 0;
+  struct mime_scan scan;
 
-  _parse_part(fp, b, &counter);
+  memset(&scan, 0, sizeof(scan));
+  _parse_part(fp, b, &scan);
+  FREE(&scan.dashes);
 }
 
 BODY *mutt_parse_messageRFC822(FILE *fp, BODY *parent)
 {
-  int counter = 0;
+  struct mime_scan scan;
+  BODY *msg;
 
-  return _parse_messageRFC822(fp, parent, &counter);
+  memset(&scan, 0, sizeof(scan));
+  msg = _parse_messageRFC822(fp, parent, &scan);
+  FREE(&scan.dashes);
+  return msg;
 }
 
 BODY *mutt_parse_multipart(FILE *fp, const char *boundary, LOFF_T end_off, int digest)
 {
-  int counter = 0;
+  struct mime_scan scan;
+  BODY *head;
 
-  return _parse_multipart(fp, boundary, end_off, digest, &counter);
+  memset(&scan, 0, sizeof(scan));
+  head = _parse_multipart(fp, boundary, end_off, digest, &scan);
+  FREE(&scan.dashes);
+  return head;
 }
 
 
@@ -1894,26 +2005,136 @@ static int count_body_parts(BODY *body, int flags)
   return count < 0 ? 0 : count;
 }
 
+static void mime_skel_add(BUFFER *skel, BODY *b, int depth)
+{
+  for (; b; b = b->next)
+  {
+    mutt_buffer_add_printf(skel, "%d %d %d %s/%s\n", depth, b->type,
+                           b->disposition, TYPE(b), NONULL(b->subtype));
+    mime_skel_add(skel, b->parts, depth + 1);
+  }
+}
+
+/* Rebuilds the parts below the top level content from a MIME skeleton.
+ * Only the fields needed for counting and matching the parts are set.
+ */
+BODY *mutt_mime_skel_parts(const char *skel)
+{
+  BODY *head = NULL, *b;
+  BODY *last[MUTT_MIME_MAX_DEPTH + 2];
+  int depth, type, disposition, maxdepth = 0, n;
+  const char *p, *slash, *eol;
+
+  memset(last, 0, sizeof(last));
+
+  for (p = skel; *p; p = eol + 1)
+  {
+    if (!(eol = strchr(p, '\n')) ||
+        sscanf(p, "%d %d %d %n", &depth, &type, &disposition, &n) != 3 ||
+        p + n >= eol || !(slash = memchr(p + n, '/', eol - p - n)))
+      break;
+
+    /* the top level content is already part of the header */
+    if (depth == 0)
+      continue;
+    if (depth > maxdepth + 1 || depth > MUTT_MIME_MAX_DEPTH)
+      break;
+
+    b = mutt_new_body();
+    b->type = type;
+    b->disposition = disposition;
+    if (b->type == TYPEOTHER)
+      b->xtype = mutt_substrdup(p + n, slash);
+    b->subtype = mutt_substrdup(slash + 1, eol);
+
+    if (last[depth])
+      last[depth]->next = b;
+    else if (depth == 1)
+      head = b;
+    else
+      last[depth - 1]->parts = b;
+    last[depth] = b;
+    last[depth + 1] = NULL;
+    maxdepth = depth;
+  }
+
+  return head;
+}
+
+/* Returns a hash of the attachments rules and $count_alternatives.
+ * Attachment counts stored in the header cache are only used if the
+ * hash they were computed with still matches.
+ */
+unsigned int mutt_attach_rules_hash(void)
+{
+  LIST *lists[] = { AttachAllow, AttachExclude, InlineAllow, InlineExclude,
+                    RootAllow, RootExclude };
+  LIST *l;
+  ATTACH_MATCH *a;
+  const char *c;
+  unsigned int h = option(OPTCOUNTALTERNATIVES);
+  size_t i;
+
+  for (i = 0; i < sizeof(lists) / sizeof(lists[0]); i++)
+  {
+    for (l = lists[i]; l; l = l->next)
+    {
+      a = (ATTACH_MATCH *)l->data;
+      for (c = a->major; *c; c++)
+        h = (h * 33) + (unsigned char) *c;
+      h = (h * 33) + '/';
+      for (c = a->minor; *c; c++)
+        h = (h * 33) + (unsigned char) *c;
+      h = (h * 33) + ',';
+    }
+    h = (h * 33) + ';';
+  }
+
+  return h;
+}
+
 int mutt_count_body_parts(CONTEXT *ctx, HEADER *hdr)
 {
   short keep_parts = 0;
+  BUFFER *skel;
 
   if (hdr->attach_valid)
     return hdr->attach_total;
 
+  /* without any attachments rules nothing is counted, so don't
+   * bother opening and parsing the message */
+  if (!(AttachAllow || AttachExclude || InlineAllow || InlineExclude ||
+        RootAllow || RootExclude))
+  {
+    hdr->attach_total = 0;
+    hdr->attach_valid = 1;
+    return 0;
+  }
+
   if (hdr->content->parts)
     keep_parts = 1;
+  else if (hdr->mime_skel)
+    hdr->content->parts = mutt_mime_skel_parts(hdr->mime_skel);
   else
     mutt_parse_mime_message(ctx, hdr);
 
-  if (AttachAllow || AttachExclude || InlineAllow || InlineExclude ||
-      RootAllow || RootExclude)
-    hdr->attach_total = count_body_parts(hdr->content, MUTT_PARTS_TOPLEVEL);
-  else
-    hdr->attach_total = 0;
-
+  hdr->attach_total = count_body_parts(hdr->content, MUTT_PARTS_TOPLEVEL);
   hdr->attach_valid = 1;
 
+  /* Remember the structure of messages that had to be opened for this.
+   * It is written to the header cache with the next store of the
+   * header, or when the folder is synced or closed, not from here:
+   * counting happens while drawing the index or matching patterns,
+   * where the header's flags may hold unsynced changes. */
+  if (!hdr->mime_skel && hdr->content->parts)
+  {
+    skel = mutt_buffer_pool_get();
+    mime_skel_add(skel, hdr->content, 0);
+    hdr->mime_skel = safe_strdup(mutt_b2s(skel));
+    mutt_buffer_pool_release(&skel);
+    hdr->mime_skel_dirty = 1;
+  }
+
   if (!keep_parts)
     mutt_free_body(&hdr->content->parts);
 
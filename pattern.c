@@ -1563,29 +1563,55 @@ static int match_update_dynamic_date(pattern_t *pat)
 
 static int match_mime_content_type(const pattern_t *pat, CONTEXT *ctx, HEADER *hdr)
 {
+  int match;
+
+  /* use the structure remembered by mutt_count_body_parts() instead of
+   * reopening the message */
+  if (!hdr->content->parts && hdr->mime_skel)
+  {
+    hdr->content->parts = mutt_mime_skel_parts(hdr->mime_skel);
+    match = match_content_type(pat, hdr->content);
+    mutt_free_body(&hdr->content->parts);
+    return match;
+  }
+
   mutt_parse_mime_message(ctx, hdr);
   return match_content_type(pat, hdr->content);
 }
 
 /* Sets a value in the pattern_cache_t cache entry.
  * Normalizes the "true" value to 2. */
-static void set_pattern_cache_value(int *cache_entry, int value)
+static void set_pattern_cache_value(unsigned char *cache_entry, int value)
 {
   *cache_entry = value ? 2 : 1;
 }
 
 /* Returns 1 if the cache value is set and has a true value.
  * 0 otherwise (even if unset!) */
-static int get_pattern_cache_value(int cache_entry)
+static int get_pattern_cache_value(unsigned char cache_entry)
 {
   return cache_entry == 2;
 }
 
-static int is_pattern_cache_set(int cache_entry)
+static int is_pattern_cache_set(unsigned char cache_entry)
 {
   return cache_entry != 0;
 }
 
+/* Returns the pattern cache stored in the HEADER, for repeated
+ * evaluations by index coloring and scoring.  The contents are
+ * discarded once a command may have changed lists or alternates.
+ */
+pattern_cache_t *mutt_header_pattern_cache(HEADER *h)
+{
+  if (h->pattern_cache_gen != PatternCacheGeneration)
+  {
+    memset(&h->pattern_cache, 0, sizeof(pattern_cache_t));
+    h->pattern_cache_gen = PatternCacheGeneration;
+  }
+  return &h->pattern_cache;
+}
+
 
 /*
  * flags: MUTT_MATCH_FULL_ADDRESS - match both personal and machine address
@@ -1596,7 +1622,7 @@ mutt_pattern_exec(struct pattern_t *pat, pattern_exec_flag flags, CONTEXT *ctx,
                   pattern_cache_t *cache)
 {
   int result;
-  int *cache_entry;
+  unsigned char *cache_entry;
 
   switch (pat->op)
   {
@@ -1911,6 +1937,7 @@ int mutt_pattern_func(int op, char *prompt)
 
   if (op == MUTT_LIMIT)
   {
+    mutt_invalidate_index_lines();
     Context->vcount    = 0;
     Context->vsize     = 0;
     Context->collapsed = 0;
@@ -274,6 +274,7 @@ static int pop_fetch_headers(CONTEXT *ctx)
   void *data;
 
   hc = pop_hcache_open(pop_data, ctx->path);
+  mutt_hcache_begin(hc);
 #endif
 
   time(&pop_data->check_time);
@@ -404,6 +405,7 @@ static int pop_fetch_headers(CONTEXT *ctx)
   }
 
 #if USE_HCACHE
+  mutt_hcache_commit(hc);
   mutt_hcache_close(hc);
 #endif
 
@@ -765,6 +767,7 @@ static int pop_sync_mailbox(CONTEXT *ctx, int *index_hint)
 
 #if USE_HCACHE
     hc = pop_hcache_open(pop_data, ctx->path);
+    mutt_hcache_begin(hc);
 #endif
 
     for (i = 0, j = 0, ret = 0; ret == 0 && i < ctx->msgcount; i++)
@@ -785,7 +788,7 @@ static int pop_sync_mailbox(CONTEXT *ctx, int *index_hint)
       }
 
 #if USE_HCACHE
-      if (ctx->hdrs[i]->changed)
+      if (ctx->hdrs[i]->changed || ctx->hdrs[i]->mime_skel_dirty)
       {
         mutt_hcache_store(hc, ctx->hdrs[i]->data, ctx->hdrs[i], 0, strlen, MUTT_GENERATE_UIDVALIDITY);
       }
@@ -794,6 +797,7 @@ static int pop_sync_mailbox(CONTEXT *ctx, int *index_hint)
     }
 
 #if USE_HCACHE
+    mutt_hcache_commit(hc);
     mutt_hcache_close(hc);
 #endif
 
@@ -860,9 +864,66 @@ static int pop_save_to_header_cache(CONTEXT *ctx, HEADER *h)
   header_cache_t *hc;
 
   pop_data = (POP_DATA *)ctx->data;
-  hc = pop_hcache_open(pop_data, ctx->path);
+  if (!(hc = pop_data->hcache))
+    hc = pop_hcache_open(pop_data, ctx->path);
   rc = mutt_hcache_store(hc, h->data, h, 0, strlen, MUTT_GENERATE_UIDVALIDITY);
+  if (hc != pop_data->hcache)
+    mutt_hcache_close(hc);
+#endif
+
+  return rc;
+}
+
+static int pop_begin_header_cache(CONTEXT *ctx)
+{
+#ifdef USE_HCACHE
+  POP_DATA *pop_data = (POP_DATA *)ctx->data;
+
+  if (pop_data->hcache ||
+      !(pop_data->hcache = pop_hcache_open(pop_data, ctx->path)))
+    return -1;
+  return mutt_hcache_begin(pop_data->hcache);
+#else
+  return -1;
+#endif
+}
+
+static int pop_commit_header_cache(CONTEXT *ctx)
+{
+  int rc = -1;
+#ifdef USE_HCACHE
+  POP_DATA *pop_data = (POP_DATA *)ctx->data;
+
+  rc = mutt_hcache_commit(pop_data->hcache);
+  mutt_hcache_close(pop_data->hcache);
+  pop_data->hcache = NULL;
+#endif
+
+  return rc;
+}
+
+/* Drops the header cache records of messages no longer on the server. */
+static int pop_purge_header_cache(CONTEXT *ctx, struct hcache_gc *gc)
+{
+  int rc = -1;
+#ifdef USE_HCACHE
+  header_cache_t *hc;
+  HASH *uidls;
+  const char *uidl;
+  int i;
+
+  uidls = hash_create(MAX(ctx->msgcount, 1), 0);
+  for (i = 0; i < ctx->msgcount; i++)
+  {
+    if (!(uidl = ctx->hdrs[i]->data))
+      continue;
+    hash_insert(uidls, *uidl == '/' ? uidl + 1 : uidl, ctx->hdrs[i]);
+  }
+
+  hc = pop_hcache_open((POP_DATA *)ctx->data, ctx->path);
+  rc = mutt_hcache_purge(hc, mutt_hcache_keep_listed, uidls, gc);
   mutt_hcache_close(hc);
+  hash_destroy(&uidls, NULL);
 #endif
 
   return rc;
@@ -1043,4 +1104,7 @@ struct mx_ops mx_pop_ops = {
   .open_new_msg = NULL,
   .sync = pop_sync_mailbox,
   .save_to_header_cache = pop_save_to_header_cache,
+  .begin_header_cache = pop_begin_header_cache,
+  .commit_header_cache = pop_commit_header_cache,
+  .purge_header_cache = pop_purge_header_cache,
 };
@@ -23,6 +23,9 @@
 #include "mutt_socket.h"
 #include "mutt_curses.h"
 #include "bcache.h"
+#ifdef USE_HCACHE
+#include "hcache.h"
+#endif
 
 #define POP_PORT 110
 #define POP_SSL_PORT 995
@@ -76,6 +79,9 @@ typedef struct
   char *auth_list;              /* list of auth mechanisms */
   char *timestamp;
   body_cache_t *bcache;         /* body cache */
+#ifdef USE_HCACHE
+  header_cache_t *hcache;       /* open between begin/commit_header_cache */
+#endif
   char err_msg[POP_CMD_RESPONSE];
   POP_CACHE cache[POP_CACHE_LEN];
 } POP_DATA;
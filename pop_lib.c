@@ -465,7 +465,7 @@ int pop_fetch_data(POP_DATA *pop_data, char *query, progress_t *progressbar,
                    int (*funct)(char *, void *), void *data)
 {
   char buf[LONG_STRING];
-  char *inbuf;
+  char *inbuf = NULL;
   char *p;
   int ret, chunk = 0;
   long pos = 0;
@@ -476,8 +476,6 @@ int pop_fetch_data(POP_DATA *pop_data, char *query, progress_t *progressbar,
   if (ret < 0)
     return ret;
 
-  inbuf = safe_malloc(sizeof(buf));
-
   FOREVER
   {
     chunk = mutt_socket_readln_d(buf, sizeof(buf), pop_data->conn, MUTT_SOCK_LOG_HDR);
@@ -496,24 +494,28 @@ int pop_fetch_data(POP_DATA *pop_data, char *query, progress_t *progressbar,
       p++;
     }
 
-    strfcpy(inbuf + lenbuf, p, sizeof(buf));
     pos += chunk;
 
-    /* cast is safe since we break out of the loop when chunk<=0 */
-    if ((size_t)chunk >= sizeof(buf))
-    {
-      lenbuf += strlen(p);
-    }
-    else
+    /* Lines that fit into buf are handed to funct directly.  Only
+     * longer lines are assembled in inbuf.
+     * cast is safe since we break out of the loop when chunk<=0 */
+    if (lenbuf || (size_t)chunk >= sizeof(buf))
     {
-      if (progressbar)
-        mutt_progress_update(progressbar, pos, -1);
-      if (ret == 0 && funct(inbuf, data) < 0)
-        ret = -3;
-      lenbuf = 0;
+      safe_realloc(&inbuf, lenbuf + sizeof(buf));
+      strfcpy(inbuf + lenbuf, p, sizeof(buf));
+      if ((size_t)chunk >= sizeof(buf))
+      {
+        lenbuf += strlen(p);
+        continue;
+      }
+      p = inbuf;
     }
 
-    safe_realloc(&inbuf, lenbuf + sizeof(buf));
+    if (progressbar)
+      mutt_progress_update(progressbar, pos, -1);
+    if (ret == 0 && funct(p, data) < 0)
+      ret = -3;
+    lenbuf = 0;
   }
 
   FREE(&inbuf);
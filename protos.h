@@ -202,6 +202,8 @@ void mutt_buffer_sanitize_filename(BUFFER *d, const char *f, int flags);
 void mutt_canonical_charset(char *, size_t, const char *);
 void mutt_check_stats(void);
 int mutt_count_body_parts(CONTEXT *, HEADER *);
+unsigned int mutt_attach_rules_hash(void);
+BODY *mutt_mime_skel_parts(const char *);
 void mutt_check_rescore(CONTEXT *);
 void mutt_clear_error(void);
 void mutt_clear_pager_position(void);
@@ -249,6 +251,7 @@ void mutt_free_regexp(REGEXP **);
 void mutt_generate_header(char *, size_t, HEADER *, int);
 const char *mutt_getcwd(BUFFER *);
 void mutt_help(int);
+void mutt_invalidate_index_lines(void);
 const char *mutt_idxfmt_hook(const char *, CONTEXT *, HEADER *);
 void mutt_draw_tree(CONTEXT *);
 void mutt_check_lookup_list(BODY *, char *, size_t);
@@ -463,6 +466,7 @@ int mutt_buffer_from_base64(BUFFER *, const char *);
 #define new_pattern() safe_calloc(1, sizeof(pattern_t))
 
 int mutt_pattern_exec(struct pattern_t *pat, pattern_exec_flag flags, CONTEXT *ctx, HEADER *h, pattern_cache_t *);
+pattern_cache_t *mutt_header_pattern_cache(HEADER *);
 pattern_t *mutt_pattern_comp(/* const */ char *s, int flags, BUFFER *err);
 void mutt_check_simple(BUFFER *s, const char *simple);
 void mutt_pattern_free(pattern_t **pat);
@@ -85,7 +85,7 @@ static size_t convert_string(ICONV_CONST char *f, size_t flen,
 
   if (flen >= SIZE_MAX / MB_LEN_MAX)
   {
-    iconv_close(cd);
+    mutt_iconv_close(cd);
     return (size_t)(-1);
   }
 
@@ -96,7 +96,7 @@ static size_t convert_string(ICONV_CONST char *f, size_t flen,
   {
     e = errno;
     FREE(&buf);
-    iconv_close(cd);
+    mutt_iconv_close(cd);
     errno = e;
     return (size_t)(-1);
   }
@@ -106,7 +106,7 @@ static size_t convert_string(ICONV_CONST char *f, size_t flen,
 
   safe_realloc(&buf, ob - buf + 1);
   *t = buf;
-  iconv_close(cd);
+  mutt_iconv_close(cd);
 
   return n;
 }
@@ -310,11 +310,11 @@ static size_t try_block(ICONV_CONST char *d, size_t dlen,
         iconv(cd, 0, 0, &ob, &obl) == (size_t)(-1))
     {
       assert(errno == E2BIG);
-      iconv_close(cd);
+      mutt_iconv_close(cd);
       assert(ib > d);
       return (ib - d == dlen) ? dlen : ib - d + 1;
     }
-    iconv_close(cd);
+    mutt_iconv_close(cd);
   }
   else
   {
@@ -379,7 +379,7 @@ static size_t encode_block(char *s, char *d, size_t dlen,
     n1 = iconv(cd, &ib, &ibl, &ob, &obl);
     n2 = iconv(cd, 0, 0, &ob, &obl);
     assert(n1 != (size_t)(-1) && n2 != (size_t)(-1));
-    iconv_close(cd);
+    mutt_iconv_close(cd);
     return (*encoder)(s, buf1, ob - buf1, tocode);
   }
   else
@@ -671,15 +671,21 @@ void rfc2047_encode_envelope(ENVELOPE *e)
   rfc2047_encode_string(&e->subject);
 }
 
-static int rfc2047_decode_word(BUFFER *d, const char *s, char **charset)
+/* Decodes the encoded word at s and appends the result to d.  The
+ * decoded text is written straight into d, which is large enough
+ * since decoding never makes the text longer.
+ */
+static int rfc2047_decode_word(BUFFER *d, const char *s, char *charset,
+                               size_t charsetlen)
 {
   const char *pp, *pp1;
-  char *pd, *d0;
+  char *pd = NULL;
   const char *t, *t1;
   int enc = 0, count = 0;
   int rv = -1;
+  size_t start = mutt_buffer_len(d);
 
-  pd = d0 = safe_malloc(strlen(s));
+  *charset = '\0';
 
   for (pp = s; (pp1 = strchr(pp, '?')); pp = pp1 + 1)
   {
@@ -701,7 +707,7 @@ static int rfc2047_decode_word(BUFFER *d, const char *s, char **charset)
         t = pp1;
         if ((t1 = memchr(pp, '*', t - pp)))
           t = t1;
-        *charset = mutt_substrdup(pp, t);
+        strfcpy(charset, pp, MIN(charsetlen, (size_t)(t - pp + 1)));
         break;
       case 3:
         if (toupper((unsigned char) *pp) == 'Q')
@@ -712,6 +718,8 @@ static int rfc2047_decode_word(BUFFER *d, const char *s, char **charset)
           goto error_out_0;
         break;
       case 4:
+        mutt_buffer_increase_size(d, start + (pp1 - pp) + 1);
+        pd = d->data + start;
         if (enc == ENCQUOTEDPRINTABLE)
         {
           for (; pp < pp1; pp++)
@@ -758,10 +766,20 @@ static int rfc2047_decode_word(BUFFER *d, const char *s, char **charset)
     }
   }
 
-  mutt_buffer_addstr(d, d0);
+  if (!pd)
+    goto error_out_0;
+
+  /* like mutt_buffer_addstr(), stop at a decoded NUL */
+  d->dptr = d->data + start + strlen(d->data + start);
   rv = 0;
+  return rv;
+
 error_out_0:
-  FREE(&d0);
+  if (d->data)
+  {
+    d->dptr = d->data + start;
+    *d->dptr = '\0';
+  }
   return rv;
 }
 
@@ -857,7 +875,7 @@ static void convert_and_add_text(BUFFER *d, const char *text, size_t len)
     mutt_buffer_addstr_n(d, text, len);
 }
 
-static void convert_and_add_word(BUFFER *d, BUFFER *word, char **charset)
+static void convert_and_add_word(BUFFER *d, BUFFER *word, char *charset)
 {
   char *t;
 
@@ -866,7 +884,7 @@ static void convert_and_add_word(BUFFER *d, BUFFER *word, char **charset)
     goto out;
 
   if (*charset)
-    mutt_convert_string(&t, *charset, Charset, MUTT_ICONV_HOOK_FROM);
+    mutt_convert_string(&t, charset, Charset, MUTT_ICONV_HOOK_FROM);
 
   mutt_filter_unprintable(&t);
   mutt_buffer_addstr(d, t);
@@ -874,7 +892,7 @@ static void convert_and_add_word(BUFFER *d, BUFFER *word, char **charset)
 
 out:
   mutt_buffer_clear(word);
-  FREE(charset);  /* __FREE_CHECKED__ */
+  *charset = '\0';
 }
 
 /* try to decode anything that looks like a valid RFC2047 encoded
@@ -884,7 +902,7 @@ void rfc2047_decode(char **pd)
 {
   const char *s = *pd;
   const char *word_begin, *word_end;
-  char *word_charset = NULL, *accumulated_charset = NULL;
+  char word_charset[STRING], accumulated_charset[STRING];
   size_t m, n;
   int found_encoded = 0, rc;
   BUFFER *d, *word, *accumulated_word;
@@ -892,6 +910,14 @@ void rfc2047_decode(char **pd)
   if (!s || !*s)
     return;
 
+  /* Most header fields contain no encoded words.  Unless
+   * $assumed_charset asks for raw text to be converted, they would be
+   * copied through unchanged. */
+  if (!AssumedCharset && !strstr(s, "=?"))
+    return;
+
+  accumulated_charset[0] = '\0';
+
   d = mutt_buffer_pool_get();
   word = mutt_buffer_pool_get();
   accumulated_word = mutt_buffer_pool_get();
@@ -905,7 +931,7 @@ void rfc2047_decode(char **pd)
 
       if (!found_encoded || ((strspn(s, " \t\r\n") != n)))
       {
-        convert_and_add_word(d, accumulated_word, &accumulated_charset);
+        convert_and_add_word(d, accumulated_word, accumulated_charset);
 
         if (option(OPTIGNORELWS))
         {
@@ -928,14 +954,15 @@ void rfc2047_decode(char **pd)
       }
     }
 
-    rc = rfc2047_decode_word(word, word_begin, &word_charset);
+    rc = rfc2047_decode_word(word, word_begin, word_charset,
+                             sizeof(word_charset));
 
     /* If the decode failed, or it's a different charset, write out
      * the accumulated part. */
     if ((rc != 0) ||
         (ascii_strcasecmp(accumulated_charset, word_charset) != 0))
     {
-      convert_and_add_word(d, accumulated_word, &accumulated_charset);
+      convert_and_add_word(d, accumulated_word, accumulated_charset);
     }
 
     /* If the decode failed, write out the raw string. */
@@ -947,16 +974,15 @@ void rfc2047_decode(char **pd)
     else
     {
       mutt_buffer_addstr(accumulated_word, mutt_b2s(word));
-      mutt_str_replace(&accumulated_charset, word_charset);
+      strfcpy(accumulated_charset, word_charset, sizeof(accumulated_charset));
     }
 
     mutt_buffer_clear(word);
-    FREE(&word_charset);
     found_encoded = 1;
     s = word_end;
   }
 
-  convert_and_add_word(d, accumulated_word, &accumulated_charset);
+  convert_and_add_word(d, accumulated_word, accumulated_charset);
 
   if (*s)
   {
@@ -65,8 +65,7 @@ void mutt_check_rescore(CONTEXT *ctx)
     for (i = 0; ctx && i < ctx->msgcount; i++)
     {
       mutt_score_message(ctx, ctx->hdrs[i], 1);
-      ctx->hdrs[i]->color.pair = 0;
-      ctx->hdrs[i]->color.attrs = 0;
+      ctx->hdrs[i]->color_valid = 0;
     }
   }
   unset_option(OPTNEEDRESCORE);
@@ -138,13 +137,13 @@ int mutt_parse_score(BUFFER *buf, BUFFER *s, union pointer_long_t udata, BUFFER
 void mutt_score_message(CONTEXT *ctx, HEADER *hdr, int upd_ctx)
 {
   SCORE *tmp;
-  pattern_cache_t cache;
+  pattern_cache_t *cache;
 
-  memset(&cache, 0, sizeof(cache));
+  cache = mutt_header_pattern_cache(hdr);
   hdr->score = 0; /* in case of re-scoring */
   for (tmp = Score; tmp; tmp = tmp->next)
   {
-    if (mutt_pattern_exec(tmp->pat, MUTT_MATCH_FULL_ADDRESS, NULL, hdr, &cache) > 0)
+    if (mutt_pattern_exec(tmp->pat, MUTT_MATCH_FULL_ADDRESS, NULL, hdr, cache) > 0)
     {
       if (tmp->exact || tmp->val == 9999 || tmp->val == -9999)
       {
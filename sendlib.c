@@ -101,9 +101,19 @@ static void encode_quoted(FGETCONV * fc, FILE *fout, int istext)
 {
   int c, linelen = 0;
   char line[77], savechar;
+  char bufi[LONG_STRING * 2];
+  size_t n = 0, pos = 0;
 
-  while ((c = fgetconv(fc)) != EOF)
+  for (;;)
   {
+    if (pos == n)
+    {
+      if ((n = fgetconv_read(bufi, sizeof(bufi), fc)) == 0)
+        break;
+      pos = 0;
+    }
+    c = (unsigned char) bufi[pos++];
+
     /* Wrap the line if needed. */
     if (linelen == 76 && ((istext && c != '\n') || !istext))
     {
@@ -284,29 +294,80 @@ static void b64_putc(char c, FILE *fout)
 }
 
 
+/* Encodes all complete triples of src, producing the same line
+ * breaks as b64_flush().  Returns the number of bytes consumed.
+ */
+static size_t b64_encode_triples(const unsigned char *src, size_t len, FILE *fout)
+{
+  char out[LONG_STRING];
+  size_t i, o = 0;
+
+  for (i = 0; i + 3 <= len; i += 3)
+  {
+    if (b64_linelen >= 72)
+    {
+      out[o++] = '\n';
+      b64_linelen = 0;
+    }
+
+    out[o++] = B64Chars[src[i] >> 2];
+    out[o++] = B64Chars[((src[i] & 0x3) << 4) | (src[i+1] >> 4)];
+    out[o++] = B64Chars[((src[i+1] & 0xf) << 2) | (src[i+2] >> 6)];
+    out[o++] = B64Chars[src[i+2] & 0x3f];
+    b64_linelen += 4;
+
+    if (o + 5 > sizeof(out))
+    {
+      fwrite(out, o, 1, fout);
+      o = 0;
+    }
+  }
+
+  if (o)
+    fwrite(out, o, 1, fout);
+
+  return i;
+}
+
 static void encode_base64(FGETCONV * fc, FILE *fout, int istext)
 {
-  int ch, ch1 = EOF;
+  char bufi[LONG_STRING * 3];
+  unsigned char buf[sizeof(bufi) * 2 + 2];
+  size_t n, i, l = 0, used;
+  int ch1 = EOF;
 
   b64_num = b64_linelen = 0;
 
-  while ((ch = fgetconv(fc)) != EOF)
+  while ((n = fgetconv_read(bufi, sizeof(bufi), fc)) > 0)
   {
-    if (istext && ch == '\n' && ch1 != '\r')
-      b64_putc('\r', fout);
-    b64_putc(ch, fout);
-    ch1 = ch;
+    /* buf holds the up to two bytes left over from the previous
+     * block, followed by this block with LF expanded to CRLF. */
+    for (i = 0; i < n; i++)
+    {
+      if (istext && bufi[i] == '\n' && ch1 != '\r')
+        buf[l++] = '\r';
+      buf[l++] = bufi[i];
+      ch1 = bufi[i];
+    }
+
+    used = b64_encode_triples(buf, l, fout);
+    memmove(buf, buf + used, l - used);
+    l -= used;
   }
+
+  for (i = 0; i < l; i++)
+    b64_putc(buf[i], fout);
   b64_flush(fout);
   fputc('\n', fout);
 }
 
 static void encode_8bit(FGETCONV *fc, FILE *fout, int istext)
 {
-  int ch;
+  char buf[LONG_STRING * 2];
+  size_t n;
 
-  while ((ch = fgetconv(fc)) != EOF)
-    fputc(ch, fout);
+  while ((n = fgetconv_read(buf, sizeof(buf), fc)) > 0)
+    fwrite(buf, n, 1, fout);
 }
 
 
@@ -818,9 +879,9 @@ static size_t convert_file_to(FILE *file, const char *fromcode,
 
   for (i = 0; i < ncodes; i++)
     if (cd[i] != (iconv_t)(-1))
-      iconv_close(cd[i]);
+      mutt_iconv_close(cd[i]);
 
-  iconv_close(cd1);
+  mutt_iconv_close(cd1);
   FREE(&cd);
   FREE(&infos);
   FREE(&score);
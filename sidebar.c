@@ -31,6 +31,8 @@
 
 /* Previous values for some sidebar config */
 static short PreviousSort = SORT_ORDER;  /* sidebar_sort_method */
+static char *PreviousFormat = NULL;      /* sidebar_format of the cached lines */
+static short FormatIsFilter = 0;         /* sidebar_format ends in '|' */
 
 /**
  * struct sidebar_entry - Info about folders in the sidebar
@@ -40,6 +42,15 @@ typedef struct sidebar_entry
   char         box[STRING];     /* formatted mailbox name */
   BUFFY       *buffy;
   short        is_hidden;
+
+  /* The last line made by make_sidebar_entry(), and the values it was
+   * made from.  line_width is 0 if there is no cached line. */
+  char         line[STRING];
+  int          line_width;
+  int          line_count;
+  int          line_unread;
+  int          line_flagged;
+  short        line_new;
 } SBENTRY;
 
 static int EntryCount = 0;
@@ -237,6 +248,55 @@ static void make_sidebar_entry(char *buf, unsigned int buflen, int width, const
   }
 }
 
+/**
+ * sidebar_line_cached - Can the cached line of an entry be drawn again
+ * @sbe:     Sidebar entry
+ * @box:     Mailbox name
+ * @width:   Desired width in screen cells
+ *
+ * The line of the open mailbox is never reused, as it may show counts
+ * from the Context.
+ *
+ * Returns:
+ *      1: sbe->line is up to date
+ *      0: the line has to be made again
+ */
+static int sidebar_line_cached(SBENTRY *sbe, const char *box, int width)
+{
+  BUFFY *b = sbe->buffy;
+
+  return !FormatIsFilter &&
+         (sbe->line_width == width) &&
+         (sbe->line_count == b->msg_count) &&
+         (sbe->line_unread == b->msg_unread) &&
+         (sbe->line_flagged == b->msg_flagged) &&
+         (sbe->line_new == b->new) &&
+         !mutt_strcmp(sbe->box, box) &&
+         !(Context && !mutt_strcmp(Context->realpath, b->realpath));
+}
+
+/**
+ * sidebar_lines_check_format - Drop cached lines if sidebar_format changed
+ *
+ * A format that is filtered through a command (ending in '|') may give
+ * a different line each time, so its lines are never cached.
+ */
+static void sidebar_lines_check_format(void)
+{
+  size_t len;
+  int i;
+
+  if (PreviousFormat && !mutt_strcmp(PreviousFormat, SidebarFormat))
+    return;
+  mutt_str_replace(&PreviousFormat, SidebarFormat);
+
+  len = mutt_strlen(SidebarFormat);
+  FormatIsFilter = len && SidebarFormat[len - 1] == '|';
+
+  for (i = 0; i < EntryCount; i++)
+    Entries[i]->line_width = 0;
+}
+
 /**
  * cb_qsort_sbe - qsort callback to sort SBENTRYs
  * @a: First  SBENTRY to compare
@@ -366,6 +426,7 @@ static void unsort_entries(void)
 static void sort_entries(void)
 {
   short ssm = (SidebarSortMethod & SORT_MASK);
+  int i;
 
   /* These are the only sort methods we understand */
   if ((ssm == SORT_COUNT)     ||
@@ -373,7 +434,14 @@ static void sort_entries(void)
       (ssm == SORT_FLAGGED)   ||
       (ssm == SORT_PATH)      ||
       (ssm == SORT_SUBJECT))
-    qsort(Entries, EntryCount, sizeof(*Entries), cb_qsort_sbe);
+  {
+    /* Usually nothing changed since the last redraw */
+    for (i = 1; i < EntryCount; i++)
+      if (cb_qsort_sbe(&Entries[i - 1], &Entries[i]) > 0)
+        break;
+    if (i < EntryCount)
+      qsort(Entries, EntryCount, sizeof(*Entries), cb_qsort_sbe);
+  }
   else if ((ssm == SORT_ORDER) &&
            (SidebarSortMethod != PreviousSort))
     unsort_entries();
@@ -639,6 +707,8 @@ static void draw_sidebar(int num_rows, int num_cols, int div_width)
   if (TopIndex < 0)
     return;
 
+  sidebar_lines_check_format();
+
   pretty_folder_name = mutt_buffer_pool_get();
   last_folder_name = mutt_buffer_pool_get();
   indent_folder_name = mutt_buffer_pool_get();
@@ -802,9 +872,17 @@ static void draw_sidebar(int num_rows, int num_cols, int div_width)
     else if (b->label)
       sidebar_folder_name = b->label;
 
-    char str[STRING];
-    make_sidebar_entry(str, sizeof(str), w, sidebar_folder_name, entry);
-    printw("%s", str);
+    if (!sidebar_line_cached(entry, sidebar_folder_name, w))
+    {
+      make_sidebar_entry(entry->line, sizeof(entry->line), w,
+                         sidebar_folder_name, entry);
+      entry->line_width   = w;
+      entry->line_count   = b->msg_count;
+      entry->line_unread  = b->msg_unread;
+      entry->line_flagged = b->msg_flagged;
+      entry->line_new     = b->new;
+    }
+    printw("%s", entry->line);
     row++;
   }
 
@@ -816,6 +894,14 @@ static void draw_sidebar(int num_rows, int num_cols, int div_width)
 }
 
 
+/**
+ * mutt_sb_cleanup - Free the sidebar's global data before quitting
+ */
+void mutt_sb_cleanup(void)
+{
+  FREE(&PreviousFormat);
+}
+
 /**
  * mutt_sb_draw - Completely redraw the sidebar
  *
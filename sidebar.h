@@ -24,6 +24,7 @@
 #include "buffy.h"
 
 void         mutt_sb_change_mailbox(int op);
+void         mutt_sb_cleanup(void);
 void         mutt_sb_draw(void);
 const char * mutt_sb_get_highlight(void);
 void         mutt_sb_notify_mailbox(BUFFY *b, int created);
@@ -29,6 +29,103 @@
 #include <ctype.h>
 #include <unistd.h>
 
+/* The string comparisons (from, to, subject) are expensive to perform
+ * inside a qsort comparator: every call would redo the alias lookup,
+ * IDN conversion and case folding.  While mutt_sort_headers() runs, the
+ * keys are instead extracted at most once per message, case folded, and
+ * prefixed with a packed integer of their first bytes so most
+ * comparisons never touch the strings at all.
+ *
+ * The tables are indexed by HEADER->msgno and are filled lazily, so an
+ * incremental thread resort only pays for the messages it compares.
+ */
+typedef struct sort_key
+{
+  unsigned long prefix;         /* first folded bytes of key, big endian */
+  char *key;                    /* folded key, NULL if the message has none */
+  unsigned char valid;
+} SORT_KEY;
+
+static SORT_KEY *SubjectKeys = NULL;
+static SORT_KEY *FromKeys = NULL;
+static SORT_KEY *ToKeys = NULL;
+static int SortKeysCount = 0;
+
+static void fold_sort_key(SORT_KEY *sk, const char *s, size_t maxlen)
+{
+  char *p;
+  size_t len, i;
+
+  sk->valid = 1;
+  sk->prefix = 0;
+  if (!s)
+    return;
+
+  len = mutt_strlen(s);
+  if (len > maxlen)
+    len = maxlen;
+  sk->key = safe_malloc(len + 1);
+  for (p = sk->key, i = 0; i < len; i++)
+    *p++ = tolower((unsigned char) s[i]);
+  *p = '\0';
+
+  for (i = 0; i < sizeof(unsigned long); i++)
+    sk->prefix = (sk->prefix << 8) | (i < len ? (unsigned char) sk->key[i] : 0);
+}
+
+static int compare_sort_keys(const SORT_KEY *a, const SORT_KEY *b)
+{
+  if (a->prefix != b->prefix)
+    return a->prefix < b->prefix ? -1 : 1;
+  return strcmp(a->key, b->key);
+}
+
+static SORT_KEY *alloc_sort_keys(CONTEXT *ctx, int method)
+{
+  if ((Sort & SORT_MASK) != method &&
+      (SortAux & SORT_MASK) != method &&
+      ((Sort & SORT_MASK) != SORT_THREADS ||
+       (SortThreadGroups & SORT_MASK) != method))
+    return NULL;
+
+  return safe_calloc(ctx->msgcount, sizeof(SORT_KEY));
+}
+
+static void sort_keys_init(CONTEXT *ctx)
+{
+  int i;
+
+  SortKeysCount = ctx->msgcount;
+  SubjectKeys = alloc_sort_keys(ctx, SORT_SUBJECT);
+  FromKeys = alloc_sort_keys(ctx, SORT_FROM);
+  ToKeys = alloc_sort_keys(ctx, SORT_TO);
+
+  /* the msgno is the lookup key into the tables, and is rewritten at
+   * the end of mutt_sort_headers() anyway. */
+  if (SubjectKeys || FromKeys || ToKeys)
+    for (i = 0; i < ctx->msgcount; i++)
+      ctx->hdrs[i]->msgno = i;
+}
+
+static void free_sort_keys(SORT_KEY **keys)
+{
+  int i;
+
+  if (!*keys)
+    return;
+  for (i = 0; i < SortKeysCount; i++)
+    FREE(&(*keys)[i].key);
+  FREE(keys);         /* __FREE_CHECKED__ */
+}
+
+static void sort_keys_free(void)
+{
+  free_sort_keys(&SubjectKeys);
+  free_sort_keys(&FromKeys);
+  free_sort_keys(&ToKeys);
+  SortKeysCount = 0;
+}
+
 static int compare_score(const void *a, const void *b)
 {
   const HEADER * const *pa = (const HEADER * const *) a;
@@ -70,6 +167,25 @@ static int compare_subject(const void *a, const void *b)
   return rc;
 }
 
+static int compare_subject_key(const void *a, const void *b)
+{
+  const HEADER * const *pa = (const HEADER * const *) a;
+  const HEADER * const *pb = (const HEADER * const *) b;
+  SORT_KEY *ka = &SubjectKeys[(*pa)->msgno];
+  SORT_KEY *kb = &SubjectKeys[(*pb)->msgno];
+
+  if (!ka->valid)
+    fold_sort_key(ka, (*pa)->env->real_subj, (size_t) -1);
+  if (!kb->valid)
+    fold_sort_key(kb, (*pb)->env->real_subj, (size_t) -1);
+
+  if (!ka->key)
+    return kb->key ? -1 : compare_date_sent(pa, pb);
+  if (!kb->key)
+    return 1;
+  return compare_sort_keys(ka, kb);
+}
+
 const char *mutt_get_name(ADDRESS *a)
 {
   ADDRESS *ali;
@@ -111,6 +227,34 @@ static int compare_from(const void *a, const void *b)
   return mutt_strncasecmp(fa, fb, SHORT_STRING);
 }
 
+static int compare_to_key(const void *a, const void *b)
+{
+  const HEADER * const *ppa = (const HEADER * const *) a;
+  const HEADER * const *ppb = (const HEADER * const *) b;
+  SORT_KEY *ka = &ToKeys[(*ppa)->msgno];
+  SORT_KEY *kb = &ToKeys[(*ppb)->msgno];
+
+  if (!ka->valid)
+    fold_sort_key(ka, mutt_get_name((*ppa)->env->to), SHORT_STRING);
+  if (!kb->valid)
+    fold_sort_key(kb, mutt_get_name((*ppb)->env->to), SHORT_STRING);
+  return compare_sort_keys(ka, kb);
+}
+
+static int compare_from_key(const void *a, const void *b)
+{
+  const HEADER * const *ppa = (const HEADER * const *) a;
+  const HEADER * const *ppb = (const HEADER * const *) b;
+  SORT_KEY *ka = &FromKeys[(*ppa)->msgno];
+  SORT_KEY *kb = &FromKeys[(*ppb)->msgno];
+
+  if (!ka->valid)
+    fold_sort_key(ka, mutt_get_name((*ppa)->env->from), SHORT_STRING);
+  if (!kb->valid)
+    fold_sort_key(kb, mutt_get_name((*ppb)->env->from), SHORT_STRING);
+  return compare_sort_keys(ka, kb);
+}
+
 static int compare_date_received(const void *a, const void *b)
 {
   const HEADER * const *pa = (const HEADER * const *) a;
@@ -211,13 +355,13 @@ sort_t *mutt_get_sort_func(int method)
     case SORT_DATE:
       return (compare_date_sent);
     case SORT_SUBJECT:
-      return (compare_subject);
+      return (SubjectKeys ? compare_subject_key : compare_subject);
     case SORT_FROM:
-      return (compare_from);
+      return (FromKeys ? compare_from_key : compare_from);
     case SORT_SIZE:
       return (compare_size);
     case SORT_TO:
-      return (compare_to);
+      return (ToKeys ? compare_to_key : compare_to);
     case SORT_SCORE:
       return (compare_score);
     case SORT_SPAM:
@@ -283,6 +427,8 @@ void mutt_sort_headers(CONTEXT *ctx, int init)
   if (!ctx)
     return;
 
+  mutt_invalidate_index_lines();
+
   if (!ctx->msgcount)
   {
     /* this function gets called by mutt_sync_mailbox(), which may have just
@@ -314,6 +460,8 @@ void mutt_sort_headers(CONTEXT *ctx, int init)
   if (init && ctx->tree)
     mutt_clear_threads(ctx);
 
+  sort_keys_init(ctx);
+
   if ((Sort & SORT_MASK) == SORT_THREADS)
   {
     /* if $sort_aux changed after the mailbox is sorted, then all the
@@ -327,7 +475,12 @@ void mutt_sort_headers(CONTEXT *ctx, int init)
     mutt_sort_threads(ctx, init);
   }
   else if (sort_unthreaded(ctx))
+  {
+    sort_keys_free();
     return;
+  }
+
+  sort_keys_free();
 
   /* adjust the virtual message numbers */
   ctx->vcount = 0;
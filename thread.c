@@ -240,6 +240,8 @@ void mutt_draw_tree(CONTEXT *ctx)
   int depth = 0, start_depth = 0, max_depth = 0, width = option(OPTNARROWTREE) ? 1 : 2;
   THREAD *nextdisp = NULL, *pseudo = NULL, *parent = NULL, *tree = ctx->tree;
 
+  mutt_invalidate_index_lines();
+
   /* Do the visibility calculations and free the old thread chars.
    * From now on we can simply ignore invisible subtrees
    */
@@ -692,6 +694,16 @@ static int compare_group_sortkeys(const void *a, const void *b)
                           (*((const HEADER * const *) b))->index);
 }
 
+static int threads_sorted(THREAD **array, int count, sort_t *compare)
+{
+  int i;
+
+  for (i = 1; i < count; i++)
+    if (compare(&array[i - 1], &array[i]) > 0)
+      return 0;
+  return 1;
+}
+
 THREAD *mutt_sort_subthreads(THREAD *thread, int init)
 {
   THREAD **array, *top, *last_child;
@@ -775,8 +787,13 @@ THREAD *mutt_sort_subthreads(THREAD *thread, int init)
           array[i] = thread;
         }
 
-        qsort((void *) array, i, sizeof(THREAD *),
-              has_parent ? compare_aux_threads : compare_root_threads);
+        /* a resort is usually triggered by a single new or changed
+         * member, so most sibling lists are still in order: check
+         * that with one linear pass before paying for the qsort. */
+        if (!threads_sorted(array, i,
+                            has_parent ? compare_aux_threads : compare_root_threads))
+          qsort((void *) array, i, sizeof(THREAD *),
+                has_parent ? compare_aux_threads : compare_root_threads);
 
         /* attach them back together.  make thread the last sibling. */
         thread = array[0];
@@ -1301,6 +1318,7 @@ void mutt_set_virtual(CONTEXT *ctx)
   int i, padding;
   HEADER *cur;
 
+  mutt_invalidate_index_lines();
   ctx->vcount = 0;
   ctx->vsize = 0;
   padding = mx_msg_padding_size(ctx);
@@ -1361,7 +1379,8 @@ int _mutt_traverse_thread(CONTEXT *ctx, HEADER *cur, int flag)
 
   if (flag & (MUTT_THREAD_COLLAPSE | MUTT_THREAD_UNCOLLAPSE))
   {
-    cur->color.pair = cur->color.attrs = 0; /* force index entry's color to be re-evaluated */
+    mutt_invalidate_index_lines();
+    cur->color_valid = 0; /* force index entry's color to be re-evaluated */
     cur->collapsed = flag & MUTT_THREAD_COLLAPSE;
     if (cur->virtual != -1)
     {
@@ -1393,7 +1412,7 @@ int _mutt_traverse_thread(CONTEXT *ctx, HEADER *cur, int flag)
     {
       if (flag & (MUTT_THREAD_COLLAPSE | MUTT_THREAD_UNCOLLAPSE))
       {
-        cur->color.pair = cur->color.attrs = 0; /* force index entry's color to be re-evaluated */
+        cur->color_valid = 0; /* force index entry's color to be re-evaluated */
         cur->collapsed = flag & MUTT_THREAD_COLLAPSE;
         if (!roothdr && CHECK_LIMIT)
         {